@@ -18,6 +18,50 @@
 #define TILE_SIZE 16
 #define MAP_ROWS  (int) (G_HEIGHT / TILE_SIZE)
 #define MAP_COLS  (int) (G_WIDTH / TILE_SIZE)
+#define CHUNK_TILES   8
+#define WALL_VARIANTS 1
+#define MAP_EDIT_LOG  256
+#define MAX_TEXTURES  32
+#define MAX_LEVEL_ATLASES 16
+#define ATLAS_PATH_LEN    128
+#define MAX_WATCHES   8
+#define WATCH_POLL_MS 100
+#define TEXTURE_BUDGET (32 * 1024 * 1024)
+#define SIM_REDUCED_RATE  4
+#define SIM_MAX_STEP_MS   40
+#define SIM_ACTIVE_CHUNKS 2
+#define SHEET_PATH        "./assets/tilesheet.png"
+#define LEVEL_PATH        "./assets/level.txt"
+#define SAVE_PATH         "./save.dat"
+#define SAVE_MAGIC        "CAVESAV1"
+#define INTERACT_REACH    8
+#define MAX_BODY_TRIGGERS 8
+#define PLATFORM_CELL     (4 * TILE_SIZE)
+#define CRUMBLE_MS        600
+#define CRUMBLE_RESPAWN_MS 3000
+#define SLOPE_SNAP        4
+#define IDLE_FRAMES   25
+#define IDLE_WAIT_MS  250
+#define NAV_MAX_EDGES 16
+#define NAV_BUDGET    4096
+#define MAX_LIGHTS    64
+#define LIGHT_MAX_RADIUS 12
+#define AUDIO_MAX_VOICES 64
+#define AUDIO_QUEUE_SIZE 256
+#define AUDIO_FRAMES     "256"
+#define STRESS_FRAMES    200
+#define STRESS_STEP_MS   20
+#define BENCH_OPS        (1 << 20)
+#define BENCH_INPUTS     (1 << 16)
+#define BENCH_JSON_PATH  "./bench.json"
+#define NAV_BENCH_TICKS     600
+#define NAV_BENCH_MAX_SIZE  1024
+#define NAV_BENCH_PROBES    8
+#define RENDER_BENCH_FRAMES 200
+#define RENDER_BENCH_TILES  32
+#define RENDER_BENCH_ATLASES 4
+#define PARTICLE_SIZE    2
+#define PARTICLE_GRAVITY 0.0006f
 
 typedef enum {
 	K_LEFT=0,
@@ -34,15 +78,112 @@ typedef struct {
 	bool held_keys[NUM_KEYS];
 } Move_Buffer;
 
+typedef struct {
+	/*owned copy, level atlases can come and go with reloads*/
+	char         *path;
+	SDL_Surface  *surface;
+	/*NULL while evicted, re-uploaded from surface on the next lookup*/
+	SDL_Texture  *texture;
+	size_t       bytes;
+	uint64_t     last_used;
+} Texture_Entry;
+
+typedef struct {
+	SDL_Renderer  *renderer;
+	Texture_Entry entries[MAX_TEXTURES];
+	int           count;
+	size_t        budget;
+	size_t        resident_bytes;
+	uint64_t      frame;
+	uint64_t      hits;
+	uint64_t      misses;
+	uint64_t      uploads;
+	uint64_t      upload_bytes;
+	uint64_t      evictions;
+} Texture_Manager;
+
+typedef enum {
+	WATCH_TEXTURE=0,
+	WATCH_LEVEL,
+	NUM_WATCH_KINDS
+} Watch_Kind;
+
+typedef struct {
+	const char *path;
+	Watch_Kind kind;
+	/*texture manager handle, only for WATCH_TEXTURE*/
+	int        handle;
+	/*inotify watch on the file's directory, -1 when polling*/
+	int        wd;
+	/*modify time the polling fallback compares against*/
+	SDL_Time   mtime;
+	/*set while a change waits for the main loop, so bursts collapse*/
+	bool       queued;
+	uint64_t   changed_ns;
+} Watch;
+
+typedef struct {
+	Watch         watches[MAX_WATCHES];
+	int           count;
+	/*watch indices handed from the watcher thread to the main loop, the
+	  queue and the watches' queued/changed_ns fields are behind lock*/
+	int           queue[MAX_WATCHES];
+	int           queued;
+	SDL_Mutex     *lock;
+	SDL_Thread    *thread;
+	SDL_AtomicInt quit;
+	int           fd;
+	uint64_t      reloads;
+	uint64_t      latency_ns_total;
+	uint64_t      latency_ns_max;
+	uint64_t      apply_ns_total;
+} Watcher;
+
+typedef struct {
+	bool      active;
+	/*tile id being painted while a button is down, -1 otherwise*/
+	int       brush;
+	SDL_Point cursor;
+	uint64_t  edits;
+	uint64_t  edit_ns;
+	uint64_t  edit_ns_max;
+} Editor;
+
+typedef struct {
+	/*everything that decides what ends up on screen*/
+	int          player_x;
+	int          player_y;
+	SDL_FRect    player_src;
+	uint32_t     map_seq;
+	uint32_t     light_seq;
+	int          particles;
+	int          camera_x;
+	int          camera_y;
+	uint32_t     actors;
+	uint32_t     platforms;
+	int          cursor;
+} Frame_State;
+
 typedef struct {
 	char         *name;
 	SDL_Window   *window;
 	SDL_Renderer *renderer;
 	SDL_Texture  *spritesheet;
+	Texture_Manager *textures;
+	int          sheet;
+	SDL_FPoint   camera;
 	bool         running;
 	int          width;
 	int          height;
 	Move_Buffer  m_buff;
+	Editor       editor;
+	Frame_State  last_frame;
+	bool         frame_valid;
+	int          idle_frames;
+	uint64_t     frames_drawn;
+	uint64_t     frames_skipped;
+	/*render calls issued by the draw_ functions, read by the render bench*/
+	uint64_t     draw_calls;
 } Game;
 
 typedef struct {
@@ -56,6 +197,12 @@ typedef struct {
 	bool  interacting;
 	bool  on_ground;
 	bool  jump_active;
+	/*platform being stood on, -1 for none or the tile grid*/
+	int   platform;
+	/*where that platform's box was when this body last moved with it*/
+	SDL_FPoint carried_from;
+	/*friction scale of the surface last stood on*/
+	float grip;
 	int   acc_x;
 	float walking_acc;
 	float max_speed_x;
@@ -132,6 +279,13 @@ typedef enum {
 	NUM_LOOKS
 } P_Look;
 
+typedef enum {
+	EV_JUMPED=1,
+	EV_LANDED=2,
+	EV_INTERACT=4,
+	EV_HAZARD=8,
+} P_Event;
+
 typedef struct {
 	P_State    state;
 	P_Dir      dir;
@@ -140,17 +294,128 @@ typedef struct {
 	Sprite*    curr_sprite;
 	SDL_FPoint pos;
 	Physics    physics;
+	/*P_Event flags raised during the last player_update*/
+	uint8_t    events;
+	/*trigger volumes the body was inside as of the last check*/
+	int        triggers[MAX_BODY_TRIGGERS];
+	int        num_triggers;
 } Player;
 
 typedef enum {
 	NO_TILE=0,
 	WALL,
+	ONE_WAY,
+	SLOPE_UP,
+	SLOPE_DOWN,
+	SPIKES,
+	ICE,
 	NUM_MAP_SPRITES,
 } Map_Sprites;
 
+typedef enum {
+	TF_SOLID=1,
+	TF_ONE_WAY=2,
+	TF_SLOPE=4,
+	TF_HAZARD=8,
+	TF_AUTOTILE=16,
+} Tile_Flags;
+
+typedef struct {
+	uint8_t    flags;
+	/*surface height in pixels above the tile bottom at its left and
+	  right edges, only read for TF_SLOPE*/
+	uint8_t    slope_l;
+	uint8_t    slope_r;
+	/*scales Physics.friction while standing on the tile*/
+	float      friction;
+	/*character the tile is written as in level files*/
+	char       glyph;
+	SDL_FRect  sprite;
+	SDL_FColor tint;
+} Tile_Props;
+
+extern const Tile_Props tile_props[NUM_MAP_SPRITES];
+
+typedef enum {
+	PLAT_MOVING=0,
+	PLAT_CRUMBLING,
+	NUM_PLATFORM_KINDS
+} Platform_Kind;
+
+typedef struct {
+	Platform_Kind kind;
+	SDL_FRect     box;
+	/*moving platforms ping-pong between from and to over period_ms*/
+	SDL_FPoint    from;
+	SDL_FPoint    to;
+	float         period_ms;
+	float         t_ms;
+	/*how far the platform moved on the last update, riders move with it*/
+	SDL_FPoint    delta;
+	bool          solid;
+	/*crumbling platforms count down once stood on, then respawn*/
+	bool          crumbling;
+	float         timer_ms;
+	SDL_Rect      span;
+} Platform;
+
+typedef struct {
+	int       count;
+	int       capacity;
+	Platform  *list;
+	/*uniform grid of PLATFORM_CELL squares as CSR, only rebuilt when a
+	  platform's cell span changes*/
+	int       grid_rows;
+	int       grid_cols;
+	int       *start;
+	int       *items;
+	int       items_cap;
+	bool      grid_dirty;
+	uint32_t  tick;
+	uint32_t  *stamp;
+	uint32_t  query;
+	uint64_t  queries;
+	uint64_t  tests;
+	uint64_t  rebuilds;
+} Platforms;
+
 typedef struct {
-	/*at 320x240, 16x16 tiles, the map is 20x15 tiles*/
-	int    tile_id[MAP_ROWS][MAP_COLS];
+	int  c_row;
+	int  c_col;
+	char path[ATLAS_PATH_LEN];
+} Level_Atlas;
+
+typedef struct {
+	/*at 320x240, 16x16 tiles, the test map is 20x15 tiles*/
+	int       rows;
+	int       cols;
+	int       **tile_id;
+	/*8-neighbour solidity per tile, bit 0 is north going clockwise*/
+	uint8_t   **neighbour_mask;
+	/*one bit per solid tile, mask_words 64-bit words per row*/
+	int       mask_words;
+	uint64_t  *solid_mask;
+	/*ring of recent edits, lets derived data catch up incrementally*/
+	uint32_t  edit_seq;
+	SDL_Point edit_log[MAP_EDIT_LOG];
+	/*tile layer baked into CHUNK_TILES square render targets*/
+	int         chunk_rows;
+	int         chunk_cols;
+	SDL_Texture **chunk_cache;
+	bool        *chunk_dirty;
+	/*texture manager handle of the atlas each chunk is drawn from*/
+	int         *chunk_atlas;
+	SDL_Rect    view_chunks;
+	/*chunks the level file puts on an atlas other than the sheet*/
+	Level_Atlas atlases[MAX_LEVEL_ATLASES];
+	int         num_atlases;
+	/*chunks touched since the save baseline was taken, kept as a list
+	  so saving walks only those, slot is each chunk's index or -1*/
+	int         *modified_chunks;
+	int         *modified_slot;
+	int         num_modified;
+	/*kinematic solids collided alongside the tiles, NULL for none*/
+	Platforms   *platforms;
 } Map;
 
 typedef struct {
@@ -162,19 +427,383 @@ typedef struct {
 	bool collided;
 	int row;
 	int col;
+	/*world box of whatever was hit, a tile or a platform*/
+	SDL_FRect rect;
+	int platform;
+	/*tile id that was hit, -1 for platforms*/
+	int tile;
 } Collision_Info;
 
+typedef struct {
+	bool       hit;
+	int        row;
+	int        col;
+	float      dist;
+	SDL_FPoint point;
+	SDL_Point  normal;
+} Ray_Hit;
+
+typedef enum {
+	NAV_NONE=0,
+	NAV_WALK,
+	NAV_JUMP,
+	NAV_FALL,
+	NUM_NAV_ACTIONS
+} Nav_Action;
+
+typedef struct {
+	int     to;
+	uint8_t action;
+	int     cost;
+} Nav_Edge;
+
+typedef struct {
+	int  d;
+	int  node;
+} Nav_Heap_Item;
+
+typedef struct {
+	Nav_Action action;
+	SDL_Point  target;
+	int        cost;
+} Nav_Step;
+
+typedef struct {
+	/*nodes are tile indices, row * cols + col*/
+	int           rows;
+	int           cols;
+	int           jump_tiles;
+	int           reach_tiles;
+	int           walk_cost;
+	int           jump_cost;
+	float         fall_ms_per_tile;
+	uint8_t       *standable;
+	uint8_t       *num_edges;
+	Nav_Edge      *edges;
+	/*in-edges as doubly linked lists threaded through the out-edge slots,
+	  so rebuilding a node's out-edges relinks just those*/
+	int           *in_head;
+	int           *in_next;
+	int           *in_prev;
+	/*published field, only refreshed once the repair below has settled.
+	  next is a copy of the edge so rebuilt slots can't change it under agents*/
+	int           *dist;
+	Nav_Edge      *next;
+	/*field under repair, g and rhs as in LPA*. a node is settled when
+	  the two agree, the heap holds the ones that don't*/
+	int           *work_dist;
+	int           *work_rhs;
+	int           *work_next;
+	/*nodes whose work values moved since the last publish*/
+	uint8_t       *changed;
+	int           *changed_list;
+	int           num_changed;
+	Nav_Heap_Item *heap;
+	int           heap_len;
+	int           heap_cap;
+	int           goal;
+	int           work_goal;
+	/*latest goal seen while a repair was running, -1 for none*/
+	int           pending_goal;
+	bool          building;
+	/*the heap couldn't grow, repairs stop and the last field stays up*/
+	bool          stalled;
+	uint32_t      map_seq;
+	uint64_t      publishes;
+	uint64_t      pops;
+} Nav;
+
+typedef struct {
+	bool      active;
+	SDL_Point tile;
+	int       radius;
+	/*brightness over the (2 * radius + 1)^2 tiles around tile*/
+	uint8_t   *contrib;
+} Light;
+
+typedef struct {
+	int         rows;
+	int         cols;
+	uint8_t     ambient;
+	uint8_t     *level;
+	Uint32      *pixels;
+	SDL_Texture *texture;
+	Light       lights[MAX_LIGHTS];
+	/*tiles to recombine and upload, in tile coords*/
+	bool        dirty;
+	SDL_Rect    dirty_rect;
+	uint32_t    version;
+	uint32_t    map_seq;
+	int         *queue;
+	int         *steps;
+} Lighting;
+
+typedef struct {
+	/*struct of arrays so the update loops stream and vectorise*/
+	int        count;
+	int        capacity;
+	bool       collide;
+	float      *x;
+	float      *y;
+	float      *vx;
+	float      *vy;
+	float      *life;
+	uint8_t    *frame;
+	SDL_Vertex *verts;
+	int        *indices;
+} Particles;
+
+typedef enum {
+	SFX_JUMP=0,
+	SFX_LAND,
+	NUM_SFX
+} Sfx_ID;
+
+typedef struct {
+	/*interleaved float frames already at the mixer's rate and channels*/
+	float *data;
+	int   frames;
+} Sample;
+
+typedef struct {
+	int    sample;
+	float  volume;
+	Uint64 trigger_ns;
+} Audio_Command;
+
+typedef struct {
+	int   sample;
+	int   pos;
+	float volume;
+} Voice;
+
+typedef struct {
+	SDL_AudioStream *stream;
+	SDL_AudioSpec   spec;
+	int             device_frames;
+	Sample          bank[NUM_SFX];
+	/*single producer ring, the game thread owns head, the mixer tail*/
+	Audio_Command   queue[AUDIO_QUEUE_SIZE];
+	SDL_AtomicInt   head;
+	SDL_AtomicInt   tail;
+	int             dropped;
+	/*everything below is only touched on the audio thread while it runs*/
+	Voice           voices[AUDIO_MAX_VOICES];
+	float           *mix;
+	int             mix_frames;
+	Uint64          buffers;
+	Uint64          mix_ns_total;
+	Uint64          mix_ns_max;
+	Uint64          latency_count;
+	Uint64          latency_ns_total;
+	Uint64          latency_ns_max;
+} Audio;
+
+typedef enum {
+	SIM_FULL=0,
+	SIM_REDUCED,
+	SIM_SLEEP,
+	NUM_SIM_TIERS
+} Sim_Tier;
+
+typedef struct {
+	/*a bot presses its own keys, everyone else's input stays empty*/
+	bool     on;
+	uint32_t seed;
+	int64_t  ms_left;
+} Bot;
+
+typedef struct {
+	Player      *body;
+	Move_Buffer input;
+	Sim_Tier    tier;
+	/*time owed to a reduced-rate actor since its last physics step*/
+	uint64_t    pending_ms;
+	Bot         bot;
+} Actor;
+
+typedef struct {
+	Actor    *actors;
+	int      count;
+	int      capacity;
+	uint64_t tick;
+	/*actors bucketed by the map chunk under their centre as CSR, rebuilt
+	  once a tick after they've moved*/
+	int      chunk_rows;
+	int      chunk_cols;
+	int      *chunk_start;
+	int      *chunk_items;
+	bool     buckets_dirty;
+	/*counts are for the last tick, times and wakes are running totals*/
+	int      tier_count[NUM_SIM_TIERS];
+	uint64_t tier_ns[NUM_SIM_TIERS];
+	uint64_t ticks;
+	uint64_t woken;
+} Actor_Pool;
+
+typedef struct {
+	int      max_actors;
+	int      stage_actors;
+	int      frames;
+	/*totals for the current stage, in nanoseconds*/
+	uint64_t frame_ns;
+	uint64_t frame_ns_max;
+	uint64_t sim_ns;
+	uint64_t draw_ns;
+} Stress;
+
+typedef enum {
+	INT_DOOR=0,
+	INT_CHEST,
+	INT_SWITCH,
+	NUM_INTERACT_KINDS
+} Interact_Kind;
+
+typedef struct {
+	Interact_Kind kind;
+	SDL_Point     tile;
+	/*door open, chest looted, switch thrown*/
+	bool          on;
+	/*object a switch or trigger operates, -1 for none*/
+	int           target;
+} Interactable;
+
+typedef struct {
+	int target;
+	int fired;
+} Trigger;
+
+typedef struct {
+	/*boxes in world pixels, bucketed per map chunk as CSR, anything
+	  spanning a chunk border is listed in every chunk it touches*/
+	int       count;
+	int       capacity;
+	SDL_FRect *box;
+	int       *start;
+	int       *items;
+	/*last query that reported each item, so duplicates are skipped*/
+	uint32_t  *stamp;
+} Interact_Cells;
+
+typedef struct {
+	int            chunk_rows;
+	int            chunk_cols;
+	Interactable   *objects;
+	Interact_Cells object_cells;
+	Trigger        *triggers;
+	Interact_Cells trigger_cells;
+	/*bodies a door refuses to close on*/
+	Player         *player;
+	Actor_Pool     *actors;
+	uint32_t       query;
+	bool           built;
+	uint64_t       queries;
+	uint64_t       query_ns;
+	uint64_t       uses;
+} Interactables;
+
+typedef struct {
+	int  id;
+	bool on;
+} Save_Object;
+
+typedef struct {
+	/*a consistent copy taken on the main thread, the writer owns it after*/
+	char        *path;
+	int         rows;
+	int         cols;
+	int         num_chunks;
+	int         *chunk_ids;
+	uint8_t     *tiles;
+	const uint8_t *baseline;
+	int         chunk_cols;
+	SDL_FPoint  player_pos;
+	int         num_objects;
+	Save_Object *objects;
+	size_t      bytes;
+	bool        ok;
+	uint64_t    start_ns;
+	uint64_t    snapshot_ns;
+	SDL_AtomicInt *done;
+} Save_Job;
+
+typedef struct {
+	int           rows;
+	int           cols;
+	int           chunk_rows;
+	int           chunk_cols;
+	/*tile ids as generated or loaded, deltas are taken against these*/
+	uint8_t       *baseline;
+	/*encoded deltas read from a save, applied when their chunk goes active*/
+	uint8_t       **pending;
+	int           *pending_len;
+	bool          *has_pending;
+	/*chunks queued by the last load, some may have been applied since*/
+	int           *pending_list;
+	int           pending_total;
+	int           pending_count;
+	SDL_Thread    *writer;
+	SDL_AtomicInt done;
+	Save_Job      *job;
+	uint64_t      saves;
+	uint64_t      chunks_applied;
+} Save_State;
+
+typedef enum {
+	BENCH_COLLIDING_TILES=0,
+	BENCH_WALL_COLLISION,
+	BENCH_COLLISION_RECTS,
+	BENCH_PLAYER_X,
+	BENCH_PLAYER_Y,
+	NUM_BENCH_KERNELS
+} Bench_Kernel;
+
+typedef struct {
+	/*BENCH_INPUTS entries, a power of two so loops can wrap with a mask*/
+	int        n;
+	SDL_FRect  *rects;
+	SDL_FPoint *pos;
+	SDL_FPoint *vel;
+} Bench_Input;
+
+typedef struct {
+	const char *kernel;
+	int        size;
+	float      density;
+	int        ops;
+	double     ns_per_op;
+} Bench_Result;
+
+typedef struct {
+	float density;
+	int   sprites;
+} Render_Scene;
+
+typedef struct {
+	float    density;
+	int      sprites;
+	/*chunks re-baked every frame instead of drawn from the cache*/
+	bool     rebake;
+	double   draw_calls;
+	double   submit_ms;
+	double   fps;
+	uint32_t checksum;
+} Render_Result;
+
 /*::main*/
 Game*			init_game_struct(char* name, int w, int h);
 void			set_game_resolution(Game *g, int r_w, int r_h, SDL_RendererLogicalPresentation lp);
-SDL_Texture*	load_spritesheet_png(Game *g, char* filepath);
+void			update_camera(Game *g, Player *p, Map *m);
 void 			begin_new_fame(Game* g);
 int 			keycode_to_keys(SDL_Keycode k);
 void 			key_down_event(Game* g, int key);
 void 			key_up_event(Game* g, int key);
-bool 			was_key_pressed(Game* g, int key);
-bool 			was_key_released(Game* g, int key);
-bool 			is_key_held(Game* g, int key);
+bool 			was_key_pressed(Move_Buffer* mb, int key);
+bool 			was_key_released(Move_Buffer* mb, int key);
+bool 			is_key_held(Move_Buffer* mb, int key);
+bool			any_key_held(Game* g);
+bool			frame_changed(Game* g, Frame_State *now);
+void			print_frame_stats(Game* g);
 
 void			free_game_struct(Game *g);
 void			force_fps(uint8_t fps, uint64_t start_ms);
@@ -183,8 +812,9 @@ void			force_fps(uint8_t fps, uint64_t start_ms);
 Player*			load_player_struct(void);
 void			init_player_sprites(Player *p);
 Sprite			load_player_sprite(int dir, int state, int looking);
-void			player_update(Game* g, Player *p, uint64_t e_t, Map *m);
-void			handle_player_input(Game* g, Player *p);
+void			player_update(Move_Buffer* mb, Player *p, uint64_t e_t, Map *m);
+void			player_update_physics(Move_Buffer* mb, Player *p, uint64_t e_t, Map *m);
+void			handle_player_input(Move_Buffer* mb, Player *p);
 void			set_state(Player *p);
 void			change_sprite(Player *p);
 void			start_moving_left(Player *p);
@@ -204,22 +834,235 @@ SDL_FRect		right_collision(Player *p, int delta);
 SDL_FRect		top_collision(Player *p, int delta);
 SDL_FRect		bot_collision(Player *p, int delta);
 void			tick_animation(Player *p, uint64_t e_t);
+SDL_Point		player_tile(Player *p);
 void			draw_player(Game *g, Player *p);
 void			free_player_struct(Player *p);
 
 /*::map*/
 Sprite*			init_map_sprites(void);
 Sprite			load_map_sprite(int id);
+Map*			alloc_map(int rows, int cols);
 Map*			gen_test_map(void);
+Map*			map_load(const char *filepath);
+bool			map_save(Map *m, const char *filepath);
+void			map_set_tile(Map *m, int row, int col, int id);
+bool			tile_is_solid(Map *m, int row, int col);
+bool			map_area_has_solid(Map *m, int top, int left, int bot, int right);
+void			map_build_masks(Map *m);
+void			map_update_mask(Map *m, int row, int col);
+int				autotile_variant(uint8_t mask);
+SDL_FRect		autotile_source(Sprite *m_s, int id, uint8_t mask);
+void			map_mark_chunk_dirty(Map *m, int row, int col);
+void			map_mark_modified(Map *m, int chunk);
+void			map_clear_modified(Map *m, int chunk);
+void			map_invalidate_chunks(Map *m);
+void			map_mark_atlas_dirty(Map *m, int atlas);
+int				map_reload(Map *m, const char *filepath);
+void			map_set_chunk_atlas(Map *m, int c_row, int c_col, int atlas);
+void			bind_level_atlases(Texture_Manager *tm, Map *m, int sheet);
+SDL_Rect		map_visible_chunks(Game* g, Map* m);
+void			release_hidden_chunks(Map* m, SDL_Rect view);
 void			draw_map(Game* g, Sprite* m_s, Map* m);
+void			draw_chunk(Game* g, Sprite* m_s, Map* m, int c_row, int c_col);
+void			draw_tile(Game* g, SDL_Texture *atlas, int id, SDL_FRect src, float x, float y);
+int				tile_from_glyph(char c);
 int				rect_top(SDL_FRect r);
 int				rect_bot(SDL_FRect r);
 int				rect_left(SDL_FRect r);
 int				rect_right(SDL_FRect r);
 Collision_Info  get_wall_collision_coords(Map *m, SDL_FRect r);
+Collision_Info  get_tile_collision(Map *m, SDL_FRect r, int dy);
+Collision_Info  get_solid_collision(Map *m, SDL_FRect r, int dx, int dy);
 Colliding_Tiles	get_colliding_tiles(Colliding_Tiles *c, SDL_FRect r);
 void			free_map(Sprite* s_a, Map* m);
 
+/*::actors*/
+Actor_Pool*		init_actor_pool(Map *m, int capacity);
+int				spawn_actor(Actor_Pool *ap, SDL_FPoint pos);
+int				populate_actors(Actor_Pool *ap, Map *m, int n);
+Sim_Tier		classify_actor(Game *g, Map *m, Actor *a);
+void			wake_actor(Actor *a, Map *m);
+void			update_actors(Game *g, Actor_Pool *ap, Map *m, Nav *nav, uint64_t e_t);
+void			steer_actor(Actor *a, Nav *nav);
+void			rebuild_actor_buckets(Actor_Pool *ap);
+int				actor_chunk(Actor_Pool *ap, SDL_FPoint pos);
+bool			actors_overlap(Actor_Pool *ap, SDL_FRect area);
+void			clear_move_edges(Move_Buffer *mb);
+void			drive_bot(Actor *a, uint64_t e_t);
+void			set_bot_key(Move_Buffer *mb, int key, bool held);
+void			clear_actor_pool(Actor_Pool *ap);
+void			draw_actors(Game *g, Actor_Pool *ap);
+uint32_t		actors_signature(Actor_Pool *ap);
+void			print_sim_stats(Actor_Pool *ap);
+void			free_actor_pool(Actor_Pool *ap);
+
+/*::watch*/
+Watcher*		init_watcher(void);
+int				add_watch(Watcher *w, const char *path, Watch_Kind kind, int handle);
+bool			start_watcher(Watcher *w);
+int				watcher_thread(void *data);
+void			watch_inotify(Watcher *w);
+void			watch_poll(Watcher *w);
+void			queue_change(Watcher *w, int watch);
+void			apply_reloads(Game *g, Watcher *w, Map *m, Interactables *ix);
+void			print_watch_stats(Watcher *w);
+void			free_watcher(Watcher *w);
+
+/*::stress*/
+Stress*			init_stress(Actor_Pool *ap, Map *m, int max_actors);
+void			stress_stage(Stress *s, Actor_Pool *ap, Map *m, int n);
+bool			stress_frame(Stress *s, Actor_Pool *ap, Map *m, uint64_t sim_ticks, uint64_t draw_ticks, uint64_t frame_ticks);
+void			print_stress_stage(Stress *s, Actor_Pool *ap);
+void			free_stress(Stress *s);
+
+/*::save*/
+Save_State*		init_save_state(Map *m);
+bool			save_game(Save_State *sv, Map *m, Player *p, Interactables *ix, char *filepath);
+int SDLCALL		save_writer(void *data);
+int				encode_chunk(const uint8_t *tiles, const uint8_t *base, uint8_t *out);
+bool			decode_chunk(const uint8_t *in, int len, uint8_t *delta);
+void			poll_save(Save_State *sv);
+void			finish_save(Save_State *sv);
+bool			load_game(Save_State *sv, Map *m, Player *p, Interactables *ix, char *filepath);
+void			apply_pending_chunks(Save_State *sv, Map *m, SDL_Rect active);
+void			apply_chunk_delta(Save_State *sv, Map *m, int chunk);
+void			free_save_job(Save_Job *job);
+void			free_save_state(Save_State *sv);
+
+/*::editor*/
+void			toggle_editor(Game *g);
+void			editor_event(Game *g, Map *m, SDL_Event *e);
+SDL_Point		editor_tile_at(Game *g, float x, float y);
+void			editor_paint_line(Game *g, Map *m, SDL_Point from, SDL_Point to);
+void			editor_paint(Editor *ed, Map *m, int row, int col);
+int				editor_cursor(Game *g, Map *m);
+void			draw_editor(Game *g, Map *m);
+void			print_editor_stats(Editor *ed);
+
+/*::platforms*/
+Platforms*		init_platforms(Map *m, int capacity);
+int				add_platform(Platforms *ps, Platform_Kind kind, SDL_FRect box, SDL_FPoint to, float period_ms);
+void			gen_test_platforms(Map *m);
+SDL_Rect		platform_cell_span(Platforms *ps, SDL_FRect box);
+void			update_platforms(Platforms *ps, uint64_t e_t);
+bool			rebuild_platform_grid(Platforms *ps);
+Collision_Info	collide_platforms(Platforms *ps, SDL_FRect r, int dx, int dy);
+void			stand_on_platform(Platforms *ps, int id);
+void			carry_rider(Player *p, Map *m);
+uint32_t		platforms_signature(Game *g, Platforms *ps);
+void			draw_platforms(Game *g, Platforms *ps);
+void			print_platform_stats(Platforms *ps);
+void			free_platforms(Platforms *ps);
+
+/*::interact*/
+Interactables*	init_interactables(int capacity);
+bool			init_interact_cells(Interact_Cells *c, int capacity);
+int				add_interactable(Interactables *ix, Interact_Kind kind, SDL_Point tile, int target);
+int				add_trigger(Interactables *ix, SDL_FRect box, int target);
+Interactables*	gen_test_interactables(Map *m);
+bool			build_interact_index(Interactables *ix, Map *m);
+void			sync_door_tiles(Interactables *ix, Map *m);
+bool			build_interact_cells(Interactables *ix, Interact_Cells *c);
+SDL_Rect		interact_chunk_span(Interactables *ix, SDL_FRect box);
+int				query_cells(Interactables *ix, Interact_Cells *c, SDL_FRect area, int *out, int max);
+int				query_interactables(Interactables *ix, SDL_FRect area, int *out, int max);
+int				query_triggers(Interactables *ix, SDL_FRect area, int *out, int max);
+int				interact_with(Interactables *ix, Map *m, Player *p);
+void			set_interact_bodies(Interactables *ix, Player *p, Actor_Pool *ap);
+void			use_interactable(Interactables *ix, Map *m, int id);
+bool			door_blocked(Interactables *ix, SDL_FRect door);
+void			check_triggers(Interactables *ix, Map *m, Player *p);
+void			check_actor_triggers(Interactables *ix, Map *m, Actor_Pool *ap);
+void			draw_interactables(Game *g, Interactables *ix);
+void			print_interact_stats(Interactables *ix);
+void			free_interact_cells(Interact_Cells *c);
+void			free_interactables(Interactables *ix);
+
+/*::nav*/
+Nav*			nav_build(Map *m, Physics *ph);
+void			nav_rebuild_columns(Nav *n, Map *m, int left, int right);
+void			nav_sync_map(Nav *n, Map *m);
+void			nav_set_goal(Nav *n, SDL_FPoint pos);
+void			nav_move_goal(Nav *n, int node);
+void			nav_update(Nav *n, Map *m, SDL_FPoint goal_pos, int budget);
+Nav_Step		nav_query(Nav *n, SDL_FPoint pos);
+void			free_nav(Nav *n);
+bool			nav_is_standable(Map *m, int row, int col);
+void			nav_build_node_edges(Nav *n, Map *m, int row, int col);
+void			nav_add_edge(Nav *n, int from, int to, Nav_Action action, int cost);
+void			nav_link_edge(Nav *n, int slot);
+void			nav_unlink_edge(Nav *n, int slot);
+void			nav_update_node(Nav *n, int node);
+void			nav_mark_changed(Nav *n, int node);
+void			nav_publish(Nav *n);
+void			print_nav_stats(Nav *n);
+bool			nav_heap_push(Nav *n, int d, int node);
+Nav_Heap_Item	nav_heap_pop(Nav *n);
+
+/*::light*/
+Lighting*		init_lighting(Game *g, Map *m, uint8_t ambient);
+int				add_light(Lighting *l, Map *m, SDL_Point tile, int radius);
+void			move_light(Lighting *l, Map *m, int id, SDL_Point tile);
+void			remove_light(Lighting *l, int id);
+void			compute_light(Lighting *l, Map *m, Light *lt);
+void			mark_light_dirty(Lighting *l, SDL_Point tile, int radius);
+void			light_sync_map(Lighting *l, Map *m);
+void			update_light_map(Lighting *l);
+void			draw_lighting(Game *g, Lighting *l);
+void			free_lighting(Lighting *l);
+
+/*::audio*/
+Audio*			init_audio(void);
+bool			load_sample(Audio *a, int id, char *filepath);
+void			synth_sample(Audio *a, int id);
+void			play_sound(Audio *a, int id, float volume);
+void SDLCALL	audio_callback(void *userdata, SDL_AudioStream *stream, int additional, int total);
+void			mix_voices(Audio *a, int frames);
+void			print_audio_stats(Audio *a);
+void			free_audio(Audio *a);
+
+/*::textures*/
+Texture_Manager* init_texture_manager(SDL_Renderer *r, size_t budget);
+int				register_texture(Texture_Manager *tm, const char *filepath);
+int				find_texture(Texture_Manager *tm, const char *filepath);
+void			begin_texture_frame(Texture_Manager *tm);
+SDL_Texture*	get_texture(Texture_Manager *tm, int handle);
+bool			evict_texture(Texture_Manager *tm);
+bool			reload_texture(Texture_Manager *tm, int handle);
+void			print_texture_stats(Texture_Manager *tm);
+void			free_texture_manager(Texture_Manager *tm);
+
+/*::particles*/
+Particles*		init_particles(int capacity, bool collide);
+void			emit_particles(Particles *ps, SDL_FPoint pos, int n, float speed, float life_ms);
+void			update_particles(Particles *ps, Map *m, uint64_t e_t);
+void			collide_particles(Particles *ps, Map *m, float dt);
+void			draw_particles(Game *g, Particles *ps);
+void			free_particles(Particles *ps);
+
+/*::bench*/
+int				run_benchmarks(bool json);
+Map*			bench_map(int size, float density, uint32_t seed);
+Bench_Input*	alloc_bench_input(int n);
+void			fill_bench_input(Bench_Input *in, Map *m, uint32_t seed);
+Bench_Result	run_bench_kernel(int kernel, Map *m, Player *p, Bench_Input *in);
+void			print_bench_result(FILE *out, Bench_Result *r, bool json, bool first);
+bool			bench_nav_publish(Player *p, int size);
+SDL_FPoint		bench_nav_goal(Nav *n, int node);
+void			free_bench_input(Bench_Input *in);
+
+/*::render_bench*/
+int				run_render_bench(void);
+Render_Result	run_render_scene(Game *g, Sprite *m_s, Map *m, Player *p, Render_Scene sc, bool rebake);
+bool			run_atlas_churn(Game *g, Sprite *m_s);
+uint32_t		surface_checksum(SDL_Surface *s);
+void			print_render_result(Render_Result *r, bool first);
+
+/*::ray*/
+Ray_Hit			raycast_tiles(Map *m, SDL_FPoint origin, SDL_FPoint dir, float max_dist);
+bool			line_of_sight(Map *m, SDL_FPoint from, SDL_FPoint to);
+int				batch_line_of_sight(Map *m, SDL_FPoint target, const SDL_FPoint *from, int n, bool *visible);
+
 
 
 #endif
@@ -0,0 +1,404 @@
+#include "caves.h"
+
+//::actors
+Actor_Pool*
+init_actor_pool(Map *m, int capacity)
+{
+    Actor_Pool *ap;
+
+    ap = calloc(1, sizeof(Actor_Pool));
+    if (ap == NULL) return NULL;
+
+    ap->capacity      = capacity;
+    ap->chunk_rows    = m->chunk_rows;
+    ap->chunk_cols    = m->chunk_cols;
+    ap->actors        = calloc(capacity, sizeof(Actor));
+    ap->chunk_start   = calloc(m->chunk_rows * m->chunk_cols + 1, sizeof(int));
+    ap->chunk_items   = malloc(sizeof(int) * (capacity > 0 ? capacity : 1));
+    ap->buckets_dirty = true;
+
+    if (ap->actors == NULL || ap->chunk_start == NULL || ap->chunk_items == NULL) {
+        free_actor_pool(ap);
+        return NULL;
+    }
+
+    return ap;
+}
+
+int
+spawn_actor(Actor_Pool *ap, SDL_FPoint pos)
+{
+    if (ap == NULL || ap->count >= ap->capacity) return -1;
+
+    Player *p = load_player_struct();
+    if (p == NULL) return -1;
+    p->pos = pos;
+
+    Actor *a = &ap->actors[ap->count];
+    *a = (Actor) {.body = p, .tier = SIM_FULL, .pending_ms = 0, .bot = {.on = false}};
+    ap->buckets_dirty = true;
+
+    return ap->count++;
+}
+
+int
+populate_actors(Actor_Pool *ap, Map *m, int n)
+{
+    int spots = 0, placed = 0, seen = 0;
+
+    for (int row = 0; row < m->rows; row++) {
+        for (int col = 0; col < m->cols; col++) {
+            spots += nav_is_standable(m, row, col);
+        }
+    }
+    if (spots == 0 || n <= 0) return 0;
+
+    /*spread them evenly over every tile something could stand on*/
+    for (int row = 0; row < m->rows && placed < n; row++) {
+        for (int col = 0; col < m->cols && placed < n; col++) {
+            if (!nav_is_standable(m, row, col)) continue;
+            if ((int64_t) seen++ * n / spots != placed) continue;
+
+            SDL_FPoint pos = (SDL_FPoint) {(float) col * TILE_SIZE, (float) row * TILE_SIZE};
+            if (spawn_actor(ap, pos) < 0) return placed;
+            placed++;
+        }
+    }
+
+    return placed;
+}
+
+Sim_Tier
+classify_actor(Game *g, Map *m, Actor *a)
+{
+    SDL_FPoint pos = a->body->pos;
+
+    /*on screen, with a tile of slack so nothing pops at the edges*/
+    if (pos.x + TILE_SIZE >= g->camera.x - TILE_SIZE && pos.x <= g->camera.x + G_WIDTH + TILE_SIZE &&
+        pos.y + TILE_SIZE >= g->camera.y - TILE_SIZE && pos.y <= g->camera.y + G_HEIGHT + TILE_SIZE) {
+        return SIM_FULL;
+    }
+
+    /*chunks within SIM_ACTIVE_CHUNKS of the view stay active*/
+    SDL_Rect view = map_visible_chunks(g, m);
+    SDL_Point tile = player_tile(a->body);
+    int c_col = tile.x / CHUNK_TILES, c_row = tile.y / CHUNK_TILES;
+
+    if (c_col >= view.x - SIM_ACTIVE_CHUNKS && c_col < view.x + view.w + SIM_ACTIVE_CHUNKS &&
+        c_row >= view.y - SIM_ACTIVE_CHUNKS && c_row < view.y + view.h + SIM_ACTIVE_CHUNKS) {
+        return SIM_REDUCED;
+    }
+
+    return SIM_SLEEP;
+}
+
+void
+wake_actor(Actor *a, Map *m)
+{
+    Player *p = a->body;
+
+    /*the time spent asleep is dropped, not replayed in one huge step,
+      but a platform it was riding still takes it along*/
+    a->pending_ms = 0;
+    carry_rider(p, m);
+    clear_move_edges(&a->input);
+
+    /*the chunk may have been edited while nobody was simulating it*/
+    for (int i = 0; i < 4; i++) {
+        SDL_FRect body = (SDL_FRect) {
+            .x = p->pos.x + p->physics.collisionY.x,
+            .y = p->pos.y + p->physics.collisionY.y,
+            .w = p->physics.collisionY.w,
+            .h = p->physics.collisionY.h,
+        };
+        Collision_Info info = get_wall_collision_coords(m, body);
+        if (!info.collided) break;
+        p->pos.y = info.row * TILE_SIZE - rect_bot(p->physics.collisionY);
+    }
+
+    p->physics.on_ground = false;
+    change_sprite(p);
+    reset_animation(p);
+}
+
+void
+update_actors(Game *g, Actor_Pool *ap, Map *m, Nav *nav, uint64_t e_t)
+{
+    int t;
+
+    for (t = 0; t < NUM_SIM_TIERS; t++) {
+        ap->tier_count[t] = 0;
+    }
+
+    for (int i = 0; i < ap->count; i++) {
+        Actor *a = &ap->actors[i];
+        Sim_Tier tier = classify_actor(g, m, a);
+        uint64_t start = SDL_GetPerformanceCounter();
+
+        if (a->bot.on) drive_bot(a, e_t);
+        else if (tier != SIM_SLEEP) steer_actor(a, nav);
+        if (a->tier == SIM_SLEEP && tier != SIM_SLEEP) {
+            wake_actor(a, m);
+            ap->woken++;
+        }
+        a->tier = tier;
+
+        switch (tier) {
+            case SIM_FULL: {
+                uint64_t dt = e_t + a->pending_ms;
+                a->pending_ms = 0;
+                player_update(&a->input, a->body, dt < SIM_MAX_STEP_MS ? dt : SIM_MAX_STEP_MS, m);
+                clear_move_edges(&a->input);
+                break;
+            }
+            case SIM_REDUCED:
+                /*staggered so the reduced actors spread across ticks*/
+                a->pending_ms += e_t;
+                if ((ap->tick + i) % SIM_REDUCED_RATE != 0) break;
+
+                while (a->pending_ms > 0) {
+                    uint64_t dt = a->pending_ms < SIM_MAX_STEP_MS ? a->pending_ms : SIM_MAX_STEP_MS;
+                    player_update_physics(&a->input, a->body, dt, m);
+                    clear_move_edges(&a->input);
+                    a->pending_ms -= dt;
+                }
+                break;
+            default:
+                a->pending_ms = 0;
+                break;
+        }
+
+        ap->tier_count[tier]++;
+        ap->tier_ns[tier] += (SDL_GetPerformanceCounter() - start) * 1000000000u
+                             / SDL_GetPerformanceFrequency();
+    }
+
+    ap->tick++;
+    ap->ticks++;
+    rebuild_actor_buckets(ap);
+}
+
+void
+rebuild_actor_buckets(Actor_Pool *ap)
+{
+    int chunks = ap->chunk_rows * ap->chunk_cols;
+    int i;
+
+    for (i = 0; i <= chunks; i++) {
+        ap->chunk_start[i] = 0;
+    }
+    for (i = 0; i < ap->count; i++) {
+        ap->chunk_start[actor_chunk(ap, ap->actors[i].body->pos) + 1]++;
+    }
+    for (i = 0; i < chunks; i++) {
+        ap->chunk_start[i + 1] += ap->chunk_start[i];
+    }
+
+    /*same cursor trick as the platform grid, shifted back afterwards*/
+    for (i = 0; i < ap->count; i++) {
+        ap->chunk_items[ap->chunk_start[actor_chunk(ap, ap->actors[i].body->pos)]++] = i;
+    }
+    for (i = chunks; i > 0; i--) {
+        ap->chunk_start[i] = ap->chunk_start[i - 1];
+    }
+    ap->chunk_start[0] = 0;
+
+    ap->buckets_dirty = false;
+}
+
+int
+actor_chunk(Actor_Pool *ap, SDL_FPoint pos)
+{
+    float side = CHUNK_TILES * TILE_SIZE;
+    int col = (int) floorf((pos.x + TILE_SIZE / 2) / side);
+    int row = (int) floorf((pos.y + TILE_SIZE / 2) / side);
+
+    /*bodies can poke past the map edge, they belong to the edge chunk*/
+    col = SDL_clamp(col, 0, ap->chunk_cols - 1);
+    row = SDL_clamp(row, 0, ap->chunk_rows - 1);
+
+    return row * ap->chunk_cols + col;
+}
+
+bool
+actors_overlap(Actor_Pool *ap, SDL_FRect area)
+{
+    if (ap == NULL || ap->count == 0) return false;
+    if (ap->buckets_dirty) rebuild_actor_buckets(ap);
+
+    /*a body lies within a tile of its centre, so a tile of slack around
+      the area covers every chunk one could be bucketed in*/
+    int first = actor_chunk(ap, (SDL_FPoint) {area.x - TILE_SIZE, area.y - TILE_SIZE});
+    int last  = actor_chunk(ap, (SDL_FPoint) {area.x + area.w, area.y + area.h});
+
+    for (int r = first / ap->chunk_cols; r <= last / ap->chunk_cols; r++) {
+        for (int c = first % ap->chunk_cols; c <= last % ap->chunk_cols; c++) {
+            int chunk = r * ap->chunk_cols + c;
+            for (int k = ap->chunk_start[chunk]; k < ap->chunk_start[chunk + 1]; k++) {
+                Player *p = ap->actors[ap->chunk_items[k]].body;
+                SDL_FRect body = (SDL_FRect) {
+                    .x = p->pos.x + p->physics.collisionY.x,
+                    .y = p->pos.y + p->physics.collisionY.y,
+                    .w = p->physics.collisionY.w,
+                    .h = p->physics.collisionY.h,
+                };
+                if (body.x < area.x + area.w && area.x < body.x + body.w &&
+                    body.y < area.y + area.h && area.y < body.y + body.h) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void
+steer_actor(Actor *a, Nav *nav)
+{
+    Player  *p = a->body;
+    Nav_Step s = nav_query(nav, p->pos);
+
+    /*one lookup into the shared field per tick. mid-air the inputs that
+      started the jump or fall are kept until it lands somewhere*/
+    if (s.action == NAV_NONE) {
+        if (!p->physics.on_ground) return;
+        set_bot_key(&a->input, K_LEFT,  false);
+        set_bot_key(&a->input, K_RIGHT, false);
+        set_bot_key(&a->input, K_Z,     false);
+        return;
+    }
+
+    int col = (int) floorf((p->pos.x + TILE_SIZE / 2) / TILE_SIZE);
+    set_bot_key(&a->input, K_LEFT,  s.target.x < col);
+    set_bot_key(&a->input, K_RIGHT, s.target.x > col);
+
+    /*a jump needs a fresh press, so a held key is let go for a tick first*/
+    bool jump = s.action == NAV_JUMP;
+    if (jump && p->physics.on_ground && a->input.held_keys[K_Z]) jump = false;
+    set_bot_key(&a->input, K_Z, jump);
+}
+
+void
+clear_move_edges(Move_Buffer *mb)
+{
+    /*presses and releases live until the actor actually runs a tick*/
+    for (int i = 0; i < NUM_KEYS; i++) {
+        mb->pressed_keys[i]  = false;
+        mb->released_keys[i] = false;
+    }
+}
+
+void
+drive_bot(Actor *a, uint64_t e_t)
+{
+    Bot *b = &a->bot;
+
+    b->ms_left -= (int64_t) e_t;
+    if (b->ms_left > 0) return;
+
+    b->seed = b->seed * 1664525u + 1013904223u;
+    uint32_t r = b->seed >> 8;
+
+    /*each pattern is a walk direction or none, an occasional jump held
+      for the whole pattern and sometimes a look up or down*/
+    int  walk = r % 3;
+    int  look = (r >> 2) % 6;
+    bool jump = (r >> 5) % 4 == 0;
+
+    set_bot_key(&a->input, K_LEFT,  walk == 1);
+    set_bot_key(&a->input, K_RIGHT, walk == 2);
+    set_bot_key(&a->input, K_UP,    look == 0);
+    set_bot_key(&a->input, K_DOWN,  look == 1);
+    set_bot_key(&a->input, K_Z,     jump);
+
+    b->ms_left = 150 + (r >> 8) % 850;
+}
+
+void
+set_bot_key(Move_Buffer *mb, int key, bool held)
+{
+    if (mb->held_keys[key] == held) return;
+
+    mb->held_keys[key] = held;
+    if (held) mb->pressed_keys[key]  = true;
+    else      mb->released_keys[key] = true;
+}
+
+void
+draw_actors(Game *g, Actor_Pool *ap)
+{
+    for (int i = 0; i < ap->count; i++) {
+        if (ap->actors[i].tier == SIM_FULL) {
+            draw_player(g, ap->actors[i].body);
+        }
+    }
+}
+
+uint32_t
+actors_signature(Actor_Pool *ap)
+{
+    /*folds what the visible actors put on screen into one value for idle detection*/
+    uint32_t sig = 2166136261u;
+
+    for (int i = 0; i < ap->count; i++) {
+        Player *p = ap->actors[i].body;
+        if (ap->actors[i].tier != SIM_FULL) continue;
+
+        uint32_t v[4] = {
+            (uint32_t) round(p->pos.x), (uint32_t) round(p->pos.y),
+            (uint32_t) p->curr_sprite->source.x, (uint32_t) p->curr_sprite->source.y,
+        };
+        for (int k = 0; k < 4; k++) {
+            sig = (sig ^ v[k]) * 16777619u;
+        }
+    }
+
+    return sig;
+}
+
+void
+print_sim_stats(Actor_Pool *ap)
+{
+    static const char *names[NUM_SIM_TIERS] = {"full", "reduced", "sleep"};
+
+    if (ap == NULL || ap->ticks == 0) return;
+
+    for (int t = 0; t < NUM_SIM_TIERS; t++) {
+        printf("sim %-7s: %d actors last tick, %.3f ms/tick avg\n",
+            names[t], ap->tier_count[t], ap->tier_ns[t] / 1e6 / ap->ticks);
+    }
+    printf("sim: %llu wake-ups over %llu ticks\n",
+        (unsigned long long) ap->woken, (unsigned long long) ap->ticks);
+}
+
+void
+clear_actor_pool(Actor_Pool *ap)
+{
+    for (int i = 0; i < ap->count; i++) {
+        free(ap->actors[i].body);
+    }
+    ap->count  = 0;
+    ap->ticks  = 0;
+    ap->buckets_dirty = true;
+    ap->woken  = 0;
+    for (int t = 0; t < NUM_SIM_TIERS; t++) {
+        ap->tier_count[t] = 0;
+        ap->tier_ns[t]    = 0;
+    }
+}
+
+void
+free_actor_pool(Actor_Pool *ap)
+{
+    if (ap != NULL) {
+        printf("...freeing Actor Pool\n");
+        for (int i = 0; i < ap->count; i++) {
+            free(ap->actors[i].body);
+        }
+        free(ap->actors);
+        free(ap->chunk_start);
+        free(ap->chunk_items);
+        free(ap);
+    }
+}
@@ -0,0 +1,240 @@
+#include "caves.h"
+
+//::audio
+Audio*
+init_audio(void)
+{
+    Audio *a;
+    int frames = 0;
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        printf("Audio couldn't init: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    a = calloc(1, sizeof(Audio));
+    if (a == NULL) return NULL;
+
+    /*mix at the device's own rate so the stream never has to resample,
+      and ask for a small device buffer, it sets the latency floor*/
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, AUDIO_FRAMES);
+    a->spec = (SDL_AudioSpec) {.format = SDL_AUDIO_F32, .channels = 2, .freq = 48000};
+    if (SDL_GetAudioDeviceFormat(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &a->spec, &frames)) {
+        a->spec.format   = SDL_AUDIO_F32;
+        a->spec.channels = 2;
+    }
+    a->device_frames = frames > 0 ? frames : atoi(AUDIO_FRAMES);
+    a->mix_frames    = a->device_frames;
+    a->mix           = malloc(sizeof(float) * a->mix_frames * a->spec.channels);
+    if (a->mix == NULL) {
+        free_audio(a);
+        return NULL;
+    }
+
+    SDL_SetAtomicInt(&a->head, 0);
+    SDL_SetAtomicInt(&a->tail, 0);
+
+    if (!load_sample(a, SFX_JUMP, "./assets/jump.wav")) synth_sample(a, SFX_JUMP);
+    if (!load_sample(a, SFX_LAND, "./assets/land.wav")) synth_sample(a, SFX_LAND);
+
+    a->stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
+        &a->spec,
+        audio_callback,
+        a);
+    if (a->stream == NULL) {
+        printf("Audio stream couldn't open: %s\n", SDL_GetError());
+        free_audio(a);
+        return NULL;
+    }
+    SDL_ResumeAudioStreamDevice(a->stream);
+
+    return a;
+}
+
+bool
+load_sample(Audio *a, int id, char *filepath)
+{
+    SDL_AudioSpec wav_spec;
+    Uint8 *wav = NULL, *pcm = NULL;
+    Uint32 wav_len = 0;
+    int pcm_len = 0;
+
+    if (!SDL_LoadWAV(filepath, &wav_spec, &wav, &wav_len)) return false;
+
+    /*decode once into the mixer's format, voices then just add floats*/
+    bool ok = SDL_ConvertAudioSamples(&wav_spec, wav, (int) wav_len, &a->spec, &pcm, &pcm_len);
+    SDL_free(wav);
+    if (!ok) return false;
+
+    a->bank[id].data   = (float*) pcm;
+    a->bank[id].frames = pcm_len / (int) (sizeof(float) * a->spec.channels);
+
+    return true;
+}
+
+void
+synth_sample(Audio *a, int id)
+{
+    /*stand-ins until there are recorded effects in assets/*/
+    float len_s  = id == SFX_JUMP ? 0.09f : 0.06f;
+    int   frames = (int) (a->spec.freq * len_s);
+    int   ch     = a->spec.channels;
+    float phase  = 0.0f;
+    Uint32 noise = 0x12345678u;
+
+    float *data = SDL_malloc(sizeof(float) * frames * ch);
+    if (data == NULL) return;
+
+    for (int i = 0; i < frames; i++) {
+        float t   = (float) i / frames;
+        float env = 1.0f - t;
+        float v;
+
+        if (id == SFX_JUMP) {
+            phase += (220.0f + 440.0f * t) / a->spec.freq;
+            v = (phase - floorf(phase) < 0.5f ? 0.25f : -0.25f) * env;
+        } else {
+            noise ^= noise << 13; noise ^= noise >> 17; noise ^= noise << 5;
+            v = ((noise >> 8) / 8388608.0f - 1.0f) * 0.3f * env * env;
+        }
+        for (int c = 0; c < ch; c++) {
+            data[i * ch + c] = v;
+        }
+    }
+
+    a->bank[id].data   = data;
+    a->bank[id].frames = frames;
+}
+
+void
+play_sound(Audio *a, int id, float volume)
+{
+    if (a == NULL || id < 0 || id >= NUM_SFX || a->bank[id].data == NULL) return;
+
+    int head = SDL_GetAtomicInt(&a->head);
+    int tail = SDL_GetAtomicInt(&a->tail);
+    if (head - tail >= AUDIO_QUEUE_SIZE) {
+        a->dropped++;
+        return;
+    }
+
+    a->queue[head % AUDIO_QUEUE_SIZE] = (Audio_Command) {
+        .sample     = id,
+        .volume     = volume,
+        .trigger_ns = SDL_GetTicksNS(),
+    };
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&a->head, head + 1);
+}
+
+void SDLCALL
+audio_callback(void *userdata, SDL_AudioStream *stream, int additional, int total)
+{
+    (void)total;
+    Audio *a = userdata;
+    int frame_bytes = (int) sizeof(float) * a->spec.channels;
+    Uint64 start_ns = SDL_GetTicksNS();
+
+    /*whatever is still queued ahead of this buffer plus the device's own
+      buffer is how long a voice started now waits before it is heard*/
+    Uint64 ahead_ns = (Uint64) (SDL_GetAudioStreamQueued(stream) / frame_bytes + a->device_frames)
+                      * 1000000000u / a->spec.freq;
+
+    int tail = SDL_GetAtomicInt(&a->tail);
+    int head = SDL_GetAtomicInt(&a->head);
+    SDL_MemoryBarrierAcquire();
+
+    for (; tail != head; tail++) {
+        Audio_Command cmd = a->queue[tail % AUDIO_QUEUE_SIZE];
+        for (int v = 0; v < AUDIO_MAX_VOICES; v++) {
+            if (a->voices[v].volume > 0.0f) continue;
+            a->voices[v] = (Voice) {.sample = cmd.sample, .pos = 0, .volume = cmd.volume};
+            break;
+        }
+
+        Uint64 latency = start_ns + ahead_ns - cmd.trigger_ns;
+        a->latency_count++;
+        a->latency_ns_total += latency;
+        if (latency > a->latency_ns_max) a->latency_ns_max = latency;
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&a->tail, tail);
+
+    int frames = additional / frame_bytes;
+    while (frames > 0) {
+        int n = frames < a->mix_frames ? frames : a->mix_frames;
+        mix_voices(a, n);
+        SDL_PutAudioStreamData(stream, a->mix, n * frame_bytes);
+        frames -= n;
+    }
+
+    Uint64 mix_ns = SDL_GetTicksNS() - start_ns;
+    a->buffers++;
+    a->mix_ns_total += mix_ns;
+    if (mix_ns > a->mix_ns_max) a->mix_ns_max = mix_ns;
+}
+
+void
+mix_voices(Audio *a, int frames)
+{
+    int ch = a->spec.channels;
+    float *out = a->mix;
+
+    for (int i = 0; i < frames * ch; i++) {
+        out[i] = 0.0f;
+    }
+
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++) {
+        Voice *voice = &a->voices[v];
+        if (voice->volume <= 0.0f) continue;
+
+        Sample *s = &a->bank[voice->sample];
+        int n = s->frames - voice->pos;
+        n = n < frames ? n : frames;
+
+        const float *src = &s->data[voice->pos * ch];
+        float vol = voice->volume;
+        for (int i = 0; i < n * ch; i++) {
+            out[i] += src[i] * vol;
+        }
+
+        voice->pos += n;
+        if (voice->pos >= s->frames) voice->volume = 0.0f;
+    }
+
+    for (int i = 0; i < frames * ch; i++) {
+        out[i] = out[i] > 1.0f ? 1.0f : out[i] < -1.0f ? -1.0f : out[i];
+    }
+}
+
+void
+print_audio_stats(Audio *a)
+{
+    if (a == NULL || a->buffers == 0) return;
+
+    printf("audio: %d Hz, %d frame device buffer, %llu buffers mixed\n",
+        a->spec.freq, a->device_frames, (unsigned long long) a->buffers);
+    printf("audio: mix %.3f ms avg, %.3f ms max per buffer\n",
+        a->mix_ns_total / 1e6 / a->buffers, a->mix_ns_max / 1e6);
+    if (a->latency_count > 0) {
+        printf("audio: trigger to output %.2f ms avg, %.2f ms max over %llu sounds, %d dropped\n",
+            a->latency_ns_total / 1e6 / a->latency_count, a->latency_ns_max / 1e6,
+            (unsigned long long) a->latency_count, a->dropped);
+    }
+}
+
+void
+free_audio(Audio *a)
+{
+    if (a != NULL) {
+        printf("...freeing Audio\n");
+        /*destroying the stream stops the callback before anything it reads goes*/
+        if (a->stream != NULL) SDL_DestroyAudioStream(a->stream);
+        print_audio_stats(a);
+        for (int i = 0; i < NUM_SFX; i++) {
+            SDL_free(a->bank[i].data);
+        }
+        free(a->mix);
+        free(a);
+    }
+}
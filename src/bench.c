@@ -0,0 +1,515 @@
+#include "caves.h"
+
+/*kernel results land here so the compiler can't drop the timed loops*/
+static volatile uint64_t bench_sink;
+
+//::bench
+int
+run_benchmarks(bool json)
+{
+    static const int   bench_sizes[]     = {64, 256, 1024, 2048};
+    static const float bench_densities[] = {0.1f, 0.3f, 0.5f};
+    int n_sizes = (int) (sizeof(bench_sizes) / sizeof(bench_sizes[0]));
+    int n_dens  = (int) (sizeof(bench_densities) / sizeof(bench_densities[0]));
+    bool first  = true;
+    FILE *out   = stdout;
+
+    Bench_Input *in = alloc_bench_input(BENCH_INPUTS);
+    Player *p = load_player_struct();
+    if (in == NULL || p == NULL) {
+        printf("Couldn't allocate benchmark inputs\n");
+        free_bench_input(in);
+        free(p);
+        return 1;
+    }
+
+    /*stdout also carries the freeing chatter, so json goes to its own file*/
+    if (json) {
+        out = fopen(BENCH_JSON_PATH, "w");
+        if (out == NULL) {
+            printf("Couldn't open %s\n", BENCH_JSON_PATH);
+            free_bench_input(in);
+            free(p);
+            return 1;
+        }
+        fprintf(out, "[\n");
+    }
+
+    for (int s = 0; s < n_sizes; s++) {
+        for (int d = 0; d < n_dens; d++) {
+            int size = bench_sizes[s];
+            float density = bench_densities[d];
+            Map *m = bench_map(size, density, 0x9E3779B9u ^ (uint32_t) (s * 31 + d));
+            if (m == NULL) continue;
+
+            fill_bench_input(in, m, 1234u + (uint32_t) s);
+
+            Bench_Result r[NUM_BENCH_KERNELS];
+            for (int k = 0; k < NUM_BENCH_KERNELS; k++) {
+                r[k] = run_bench_kernel(k, m, p, in);
+                r[k].size    = size;
+                r[k].density = density;
+                print_bench_result(out, &r[k], json, first);
+                first = false;
+            }
+
+            free_map(NULL, m);
+        }
+    }
+
+    if (json) {
+        fprintf(out, "\n]\n");
+        fclose(out);
+        printf("bench: results written to %s\n", BENCH_JSON_PATH);
+    }
+
+    bool nav_ok = true;
+    for (int s = 0; s < n_sizes; s++) {
+        if (bench_sizes[s] <= NAV_BENCH_MAX_SIZE) nav_ok &= bench_nav_publish(p, bench_sizes[s]);
+    }
+
+    free_bench_input(in);
+    free(p);
+    return nav_ok ? 0 : 1;
+}
+
+bool
+bench_nav_publish(Player *p, int size)
+{
+    Map *m = bench_map(size, 0.3f, 0x5EEDu + (uint32_t) size);
+    Nav *n = m != NULL ? nav_build(m, &p->physics) : NULL;
+    int tiles = size * size, start = -1, reach = 0;
+
+    /*random maps break into pockets, so the run starts in whichever of a
+      few spread out goals has the most tiles routing to it*/
+    for (int k = 0; n != NULL && k < NAV_BENCH_PROBES; k++) {
+        int node = k * (tiles / NAV_BENCH_PROBES);
+        while (node < tiles - 1 && !n->standable[node]) node++;
+        if (!n->standable[node]) continue;
+
+        do {
+            nav_update(n, m, bench_nav_goal(n, node), tiles * NAV_MAX_EDGES);
+        } while (n->building);
+
+        int count = 0;
+        for (int i = 0; i < tiles; i++) {
+            count += n->dist[i] != INT32_MAX;
+        }
+        if (count > reach) {
+            reach = count;
+            start = node;
+        }
+    }
+    free_nav(n);
+
+    n = m != NULL && start >= 0 ? nav_build(m, &p->physics) : NULL;
+    if (n == NULL) {
+        printf("nav bench: couldn't build a %dx%d field\n", size, size);
+        free_map(NULL, m);
+        return false;
+    }
+
+    /*a field from nothing with the goal still is the yardstick*/
+    uint64_t published = n->publishes;
+    int build = 0;
+    while (n->publishes == published && build < NAV_BENCH_TICKS) {
+        nav_update(n, m, bench_nav_goal(n, start), NAV_BUDGET);
+        build++;
+    }
+
+    /*a goal move raises then lowers each node at most once, so a repair
+      costs about two builds. one in flight plus the deferred one behind
+      it gives the bound, past that the goal moves are starving the field*/
+    int bound = 4 * build + 2;
+    int since = 0, worst = 0, fields = 0, node = start;
+    published = n->publishes;
+
+    /*the goal steps to the next tile of the same region every tick, like
+      a player running across the level*/
+    for (int tick = 0; tick < NAV_BENCH_TICKS; tick++) {
+        do {
+            node = (node + 1) % tiles;
+        } while (n->dist[node] == INT32_MAX);
+
+        nav_update(n, m, bench_nav_goal(n, node), NAV_BUDGET);
+
+        since++;
+        if (n->publishes != published) {
+            published = n->publishes;
+            worst = SDL_max(worst, since);
+            since = 0;
+            fields++;
+        }
+    }
+    worst = SDL_max(worst, since);
+
+    bool ok = fields > 0 && worst <= bound;
+    printf("nav publish %5d: %d tiles in reach, %d fields over %d ticks, "
+        "worst gap %d ticks (build %d, bound %d) %s\n",
+        size, reach, fields, NAV_BENCH_TICKS, worst, build, bound, ok ? "ok" : "FAILED");
+
+    free_nav(n);
+    free_map(NULL, m);
+    return ok;
+}
+
+SDL_FPoint
+bench_nav_goal(Nav *n, int node)
+{
+    return (SDL_FPoint) {(float) (node % n->cols) * TILE_SIZE, (float) (node / n->cols) * TILE_SIZE};
+}
+
+Map*
+bench_map(int size, float density, uint32_t seed)
+{
+    Map *m = alloc_map(size, size);
+    if (m == NULL) return NULL;
+
+    /*through map_set_tile like any other edit, so the bench map can't
+      drift from what the collision code expects of a real one*/
+    for (int row = 0; row < size; row++) {
+        for (int col = 0; col < size; col++) {
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 8) / 16777216.0f < density) map_set_tile(m, row, col, WALL);
+        }
+    }
+
+    return m;
+}
+
+Bench_Input*
+alloc_bench_input(int n)
+{
+    Bench_Input *in;
+
+    in = malloc(sizeof(Bench_Input));
+    if (in == NULL) return NULL;
+
+    in->n     = n;
+    in->rects = malloc(sizeof(SDL_FRect) * n);
+    in->pos   = malloc(sizeof(SDL_FPoint) * n);
+    in->vel   = malloc(sizeof(SDL_FPoint) * n);
+
+    if (in->rects == NULL || in->pos == NULL || in->vel == NULL) {
+        free_bench_input(in);
+        return NULL;
+    }
+
+    return in;
+}
+
+void
+fill_bench_input(Bench_Input *in, Map *m, uint32_t seed)
+{
+    float max_x = (float) (m->cols - 1) * TILE_SIZE;
+    float max_y = (float) (m->rows - 1) * TILE_SIZE;
+
+    /*pre-rolled so the timed loops measure the kernels, not the generator*/
+    for (int i = 0; i < in->n; i++) {
+        float r[6];
+        for (int k = 0; k < 6; k++) {
+            seed = seed * 1664525u + 1013904223u;
+            r[k] = (seed >> 8) / 16777216.0f;
+        }
+        in->rects[i] = (SDL_FRect) {r[0] * max_x, r[1] * max_y, 4 + r[2] * 12, 4 + r[3] * 12};
+        in->pos[i]   = (SDL_FPoint) {r[0] * max_x, r[1] * max_y};
+        in->vel[i]   = (SDL_FPoint) {(r[4] - 0.5f) * 0.3f, (r[5] - 0.5f) * 0.6f};
+    }
+}
+
+Bench_Result
+run_bench_kernel(int kernel, Map *m, Player *p, Bench_Input *in)
+{
+    static const char *names[NUM_BENCH_KERNELS] = {
+        "get_colliding_tiles",
+        "get_wall_collision_coords",
+        "collision_rects",
+        "update_player_X",
+        "update_player_Y",
+    };
+    Bench_Result r = (Bench_Result) {.kernel = names[kernel], .ops = BENCH_OPS};
+    Colliding_Tiles c = {0};
+    uint64_t sink = 0;
+    int mask = in->n - 1;
+
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    switch (kernel) {
+        case BENCH_COLLIDING_TILES:
+            for (int i = 0; i < BENCH_OPS; i++) {
+                get_colliding_tiles(&c, in->rects[i & mask]);
+                sink += c.index;
+            }
+            break;
+        case BENCH_WALL_COLLISION:
+            for (int i = 0; i < BENCH_OPS; i++) {
+                Collision_Info info = get_wall_collision_coords(m, in->rects[i & mask]);
+                sink += info.collided;
+            }
+            break;
+        case BENCH_COLLISION_RECTS:
+            for (int i = 0; i < BENCH_OPS; i++) {
+                p->pos = in->pos[i & mask];
+                int delta = i & 7;
+                SDL_FRect a = left_collision(p, -delta), b = right_collision(p, delta);
+                SDL_FRect t = top_collision(p, -delta), d = bot_collision(p, delta);
+                sink += (uint64_t) (a.w + b.w + t.h + d.h);
+            }
+            break;
+        case BENCH_PLAYER_X:
+            for (int i = 0; i < BENCH_OPS; i++) {
+                p->pos               = in->pos[i & mask];
+                p->physics.vel_x     = in->vel[i & mask].x;
+                p->physics.acc_x     = (i & 3) - 1;
+                p->physics.on_ground = i & 1;
+                update_player_X(p, 16, m);
+                sink += (uint64_t) p->pos.x;
+            }
+            break;
+        case BENCH_PLAYER_Y:
+            for (int i = 0; i < BENCH_OPS; i++) {
+                p->pos               = in->pos[i & mask];
+                p->physics.vel_y     = in->vel[i & mask].y;
+                p->physics.on_ground = i & 1;
+                update_player_Y(p, 16, m);
+                sink += (uint64_t) p->pos.y;
+            }
+            break;
+        default:
+            break;
+    }
+
+    uint64_t ticks = SDL_GetPerformanceCounter() - start;
+    r.ns_per_op = (double) ticks * 1e9 / SDL_GetPerformanceFrequency() / BENCH_OPS;
+    bench_sink  = sink;
+
+    return r;
+}
+
+void
+print_bench_result(FILE *out, Bench_Result *r, bool json, bool first)
+{
+    if (json) {
+        fprintf(out, "%s  {\"kernel\": \"%s\", \"size\": %d, \"density\": %.2f, \"ops\": %d, \"ns_per_op\": %.2f}",
+            first ? "" : ",\n", r->kernel, r->size, r->density, r->ops, r->ns_per_op);
+        return;
+    }
+
+    if (first) fprintf(out, "%-26s %6s %8s %10s\n", "kernel", "size", "density", "ns/op");
+    fprintf(out, "%-26s %6d %8.2f %10.2f\n",
+        r->kernel, r->size, r->density, r->ns_per_op);
+}
+
+void
+free_bench_input(Bench_Input *in)
+{
+    if (in != NULL) {
+        free(in->rects);
+        free(in->pos);
+        free(in->vel);
+        free(in);
+    }
+}
+
+//::render_bench
+int
+run_render_bench(void)
+{
+    static const Render_Scene scenes[] = {
+        {0.1f, 1}, {0.3f, 16}, {0.5f, 64}, {0.7f, 256}, {0.9f, 1024},
+    };
+    int n_scenes = (int) (sizeof(scenes) / sizeof(scenes[0]));
+    int ok = 0;
+
+    /*a software renderer drawing into a plain surface needs no window,
+      display or GPU*/
+    SDL_Surface *target = SDL_CreateSurface(G_WIDTH, G_HEIGHT, SDL_PIXELFORMAT_RGBA8888);
+    Game   *g   = init_game_struct("caves render bench", G_WIDTH, G_HEIGHT);
+    Player *p   = load_player_struct();
+    Sprite *m_s = init_map_sprites();
+
+    if (target == NULL || g == NULL || p == NULL || m_s == NULL) {
+        printf("Couldn't allocate the render bench\n");
+        ok = 1;
+        goto cleanup;
+    }
+
+    g->renderer = SDL_CreateSoftwareRenderer(target);
+    if (g->renderer == NULL) {
+        printf("Software renderer couldn't init: %s\n", SDL_GetError());
+        ok = 1;
+        goto cleanup;
+    }
+    g->textures    = init_texture_manager(g->renderer, TEXTURE_BUDGET);
+    g->sheet       = register_texture(g->textures, SHEET_PATH);
+    g->spritesheet = get_texture(g->textures, g->sheet);
+    if (g->spritesheet == NULL) {
+        printf("Couldn't load spritesheet\n");
+        ok = 1;
+        goto cleanup;
+    }
+
+    for (int s = 0; s < n_scenes; s++) {
+        for (int rebake = 0; rebake < 2; rebake++) {
+            Map *m = bench_map(RENDER_BENCH_TILES, scenes[s].density, 0xC0FFEEu + (uint32_t) s);
+            if (m == NULL) continue;
+            bind_level_atlases(g->textures, m, g->sheet);
+
+            Render_Result r = run_render_scene(g, m_s, m, p, scenes[s], rebake);
+            print_render_result(&r, s == 0 && rebake == 0);
+            free_map(NULL, m);
+        }
+    }
+
+    if (!run_atlas_churn(g, m_s)) ok = 1;
+
+cleanup:
+    free_map(m_s, NULL);
+    free_player_struct(p);
+    if (g != NULL) free_game_struct(g);
+    SDL_DestroySurface(target);
+    return ok;
+}
+
+Render_Result
+run_render_scene(Game *g, Sprite *m_s, Map *m, Player *p, Render_Scene sc, bool rebake)
+{
+    Render_Result r = (Render_Result) {.density = sc.density, .sprites = sc.sprites, .rebake = rebake};
+    uint64_t calls  = g->draw_calls, submit = 0;
+    uint64_t start  = SDL_GetPerformanceCounter();
+
+    for (int f = 0; f < RENDER_BENCH_FRAMES; f++) {
+        uint64_t frame_start = SDL_GetPerformanceCounter();
+        /*same seed every frame, so every frame and every run is identical*/
+        uint32_t seed = 0x2545F491u;
+
+        if (rebake) map_invalidate_chunks(m);
+        begin_texture_frame(g->textures);
+        g->spritesheet = get_texture(g->textures, g->sheet);
+
+        SDL_SetRenderDrawColor(g->renderer, 5, 5, 5, 255);
+        SDL_RenderClear(g->renderer);
+
+        for (int i = 0; i < sc.sprites; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            p->pos = (SDL_FPoint) {
+                (float) ((seed >> 8) % (G_WIDTH - TILE_SIZE)),
+                (float) ((seed >> 20) % (G_HEIGHT - TILE_SIZE)),
+            };
+            p->curr_sprite = &p->sprites[(seed >> 4) % NUM_SPRITES];
+            draw_player(g, p);
+        }
+        draw_map(g, m_s, m);
+
+        submit += SDL_GetPerformanceCounter() - frame_start;
+
+        /*read back before presenting, the back buffer is undefined after*/
+        if (f == RENDER_BENCH_FRAMES - 1) {
+            SDL_Surface *shot = SDL_RenderReadPixels(g->renderer, NULL);
+            r.checksum = surface_checksum(shot);
+            SDL_DestroySurface(shot);
+        }
+        SDL_RenderPresent(g->renderer);
+    }
+
+    double freq = (double) SDL_GetPerformanceFrequency();
+    r.draw_calls = (double) (g->draw_calls - calls) / RENDER_BENCH_FRAMES;
+    r.submit_ms  = submit * 1000.0 / freq / RENDER_BENCH_FRAMES;
+    r.fps        = RENDER_BENCH_FRAMES * freq / (SDL_GetPerformanceCounter() - start);
+
+    return r;
+}
+
+bool
+run_atlas_churn(Game *g, Sprite *m_s)
+{
+    Texture_Manager *tm = g->textures;
+    int    atlas[RENDER_BENCH_ATLASES];
+    size_t budget = tm->budget;
+
+    /*extra copies of the sheet stand in for per-area tilesets, what's
+      measured is the manager paging them, not what's drawn from them*/
+    atlas[0] = g->sheet;
+    for (int i = 1; i < RENDER_BENCH_ATLASES; i++) {
+        atlas[i] = register_texture(tm, SHEET_PATH);
+        if (atlas[i] < 0) {
+            printf("atlas churn: couldn't register atlas %d\n", i);
+            return false;
+        }
+    }
+
+    /*four chunk columns per atlas is wider than the view, so at most two
+      are on screen and a budget of two makes every new area evict one*/
+    int  band = 4;
+    Map *m    = alloc_map(G_HEIGHT / TILE_SIZE, RENDER_BENCH_ATLASES * band * CHUNK_TILES);
+    if (m == NULL) return false;
+    for (int row = 0; row < m->rows; row++) {
+        for (int col = 0; col < m->cols; col++) {
+            if ((row + col) % 3 == 0) map_set_tile(m, row, col, WALL);
+        }
+    }
+    for (int c_row = 0; c_row < m->chunk_rows; c_row++) {
+        for (int c_col = 0; c_col < m->chunk_cols; c_col++) {
+            map_set_chunk_atlas(m, c_row, c_col, atlas[c_col / band]);
+        }
+    }
+
+    tm->budget = 2 * tm->entries[g->sheet].bytes;
+    uint64_t uploads = tm->uploads, evictions = tm->evictions;
+    size_t   peak    = 0;
+    float    end_x   = (float) (m->cols * TILE_SIZE - G_WIDTH);
+
+    /*across and back, so areas left behind have to page in again*/
+    for (int f = 0; f < RENDER_BENCH_FRAMES; f++) {
+        float t = (float) f / (RENDER_BENCH_FRAMES - 1);
+        g->camera = (SDL_FPoint) {(t < 0.5f ? t * 2.0f : 2.0f - t * 2.0f) * end_x, 0.0f};
+
+        begin_texture_frame(tm);
+        SDL_RenderClear(g->renderer);
+        draw_map(g, m_s, m);
+        SDL_RenderPresent(g->renderer);
+        peak = SDL_max(peak, tm->resident_bytes);
+    }
+
+    uploads   = tm->uploads - uploads;
+    evictions = tm->evictions - evictions;
+    bool ok = evictions > 0 && uploads > RENDER_BENCH_ATLASES && peak <= tm->budget;
+    printf("atlas churn: %d atlases, %.1f KiB budget, %llu uploads, %llu evictions, %.1f KiB peak %s\n",
+        RENDER_BENCH_ATLASES, tm->budget / 1024.0,
+        (unsigned long long) uploads, (unsigned long long) evictions, peak / 1024.0, ok ? "ok" : "FAILED");
+
+    tm->budget = budget;
+    g->camera  = (SDL_FPoint) {0.0f, 0.0f};
+    free_map(NULL, m);
+    return ok;
+}
+
+uint32_t
+surface_checksum(SDL_Surface *s)
+{
+    uint32_t h = 2166136261u;
+
+    if (s == NULL) return 0;
+
+    /*rows one at a time, the pitch can carry padding*/
+    for (int row = 0; row < s->h; row++) {
+        const uint8_t *px = (const uint8_t *) s->pixels + row * s->pitch;
+        for (int i = 0; i < s->w * 4; i++) {
+            h = (h ^ px[i]) * 16777619u;
+        }
+    }
+
+    return h;
+}
+
+void
+print_render_result(Render_Result *r, bool first)
+{
+    if (first) {
+        printf("%8s %8s %8s %10s %10s %10s %10s\n",
+            "density", "sprites", "chunks", "calls", "submit ms", "fps", "checksum");
+    }
+    printf("%8.2f %8d %8s %10.1f %10.3f %10.1f   %08x\n",
+        r->density, r->sprites, r->rebake ? "rebake" : "cached",
+        r->draw_calls, r->submit_ms, r->fps, r->checksum);
+}
@@ -0,0 +1,131 @@
+#include "caves.h"
+
+//::editor
+void
+toggle_editor(Game *g)
+{
+    g->editor.active = !g->editor.active;
+    g->editor.brush  = -1;
+    printf("editor %s\n", g->editor.active ? "on" : "off");
+}
+
+void
+editor_event(Game *g, Map *m, SDL_Event *e)
+{
+    Editor *ed = &g->editor;
+    if (!ed->active) return;
+
+    /*window pixels to the logical 320x240 view, then into the world*/
+    SDL_ConvertEventToRenderCoordinates(g->renderer, e);
+
+    switch (e->type) {
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            ed->cursor = editor_tile_at(g, e->button.x, e->button.y);
+            if (e->button.button == SDL_BUTTON_LEFT) {
+                ed->brush = WALL;
+            } else if (e->button.button == SDL_BUTTON_RIGHT) {
+                ed->brush = NO_TILE;
+            }
+            if (ed->brush >= 0) editor_paint(ed, m, ed->cursor.y, ed->cursor.x);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            ed->brush = -1;
+            break;
+        case SDL_EVENT_MOUSE_MOTION: {
+            SDL_Point last = ed->cursor;
+            ed->cursor = editor_tile_at(g, e->motion.x, e->motion.y);
+            /*fast drags skip tiles between events, so fill the gap*/
+            if (ed->brush >= 0) editor_paint_line(g, m, last, ed->cursor);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+SDL_Point
+editor_tile_at(Game *g, float x, float y)
+{
+    return (SDL_Point) {
+        .x = (int) floorf((x + g->camera.x) / TILE_SIZE),
+        .y = (int) floorf((y + g->camera.y) / TILE_SIZE),
+    };
+}
+
+void
+editor_paint_line(Game *g, Map *m, SDL_Point from, SDL_Point to)
+{
+    int dx = abs(to.x - from.x), sx = from.x < to.x ? 1 : -1;
+    int dy = -abs(to.y - from.y), sy = from.y < to.y ? 1 : -1;
+    int err = dx + dy;
+
+    for (;;) {
+        editor_paint(&g->editor, m, from.y, from.x);
+        if (from.x == to.x && from.y == to.y) break;
+
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err    += dy;
+            from.x += sx;
+        }
+        if (e2 <= dx) {
+            err    += dx;
+            from.y += sy;
+        }
+    }
+}
+
+void
+editor_paint(Editor *ed, Map *m, int row, int col)
+{
+    if (row < 0 || row >= m->rows || col < 0 || col >= m->cols) return;
+    if (m->tile_id[row][col] == ed->brush) return;
+
+    /*map_set_tile updates the mask, the 3x3 variants and marks the
+      owning chunks, nav and lighting catch up from the edit log*/
+    uint64_t start = SDL_GetPerformanceCounter();
+    map_set_tile(m, row, col, ed->brush);
+    uint64_t ns = (SDL_GetPerformanceCounter() - start) * 1000000000u
+                  / SDL_GetPerformanceFrequency();
+
+    ed->edits++;
+    ed->edit_ns += ns;
+    if (ns > ed->edit_ns_max) ed->edit_ns_max = ns;
+}
+
+int
+editor_cursor(Game *g, Map *m)
+{
+    SDL_Point c = g->editor.cursor;
+
+    if (!g->editor.active || c.y < 0 || c.y >= m->rows || c.x < 0 || c.x >= m->cols) return -1;
+
+    return c.y * m->cols + c.x;
+}
+
+void
+draw_editor(Game *g, Map *m)
+{
+    if (editor_cursor(g, m) < 0) return;
+
+    SDL_FRect r = (SDL_FRect) {
+        .x = g->editor.cursor.x * TILE_SIZE - g->camera.x,
+        .y = g->editor.cursor.y * TILE_SIZE - g->camera.y,
+        .w = TILE_SIZE,
+        .h = TILE_SIZE,
+    };
+
+    SDL_SetRenderDrawColor(g->renderer, 255, 220, 80, 255);
+    SDL_RenderRect(g->renderer, &r);
+}
+
+void
+print_editor_stats(Editor *ed)
+{
+    if (ed->edits == 0) return;
+
+    printf("editor: %llu tile edits, %.2f us avg, %.2f us max\n",
+        (unsigned long long) ed->edits,
+        ed->edit_ns / 1e3 / ed->edits,
+        ed->edit_ns_max / 1e3);
+}
@@ -0,0 +1,445 @@
+#include "caves.h"
+
+//::interact
+Interactables*
+init_interactables(int capacity)
+{
+    Interactables *ix;
+
+    ix = calloc(1, sizeof(Interactables));
+    if (ix == NULL) return NULL;
+
+    ix->objects  = malloc(sizeof(Interactable) * capacity);
+    ix->triggers = malloc(sizeof(Trigger) * capacity);
+
+    if (ix->objects == NULL || ix->triggers == NULL ||
+        !init_interact_cells(&ix->object_cells, capacity) ||
+        !init_interact_cells(&ix->trigger_cells, capacity)) {
+        free_interactables(ix);
+        return NULL;
+    }
+
+    return ix;
+}
+
+bool
+init_interact_cells(Interact_Cells *c, int capacity)
+{
+    c->count    = 0;
+    c->capacity = capacity;
+    c->box      = malloc(sizeof(SDL_FRect) * capacity);
+    c->stamp    = calloc(capacity, sizeof(uint32_t));
+    c->start    = NULL;
+    c->items    = NULL;
+
+    return c->box != NULL && c->stamp != NULL;
+}
+
+int
+add_interactable(Interactables *ix, Interact_Kind kind, SDL_Point tile, int target)
+{
+    Interact_Cells *c = &ix->object_cells;
+    if (ix->built || c->count >= c->capacity) return -1;
+
+    ix->objects[c->count] = (Interactable) {
+        .kind   = kind,
+        .tile   = tile,
+        .on     = false,
+        .target = target,
+    };
+    c->box[c->count] = (SDL_FRect) {
+        .x = tile.x * TILE_SIZE,
+        .y = tile.y * TILE_SIZE,
+        .w = TILE_SIZE,
+        .h = TILE_SIZE,
+    };
+
+    return c->count++;
+}
+
+int
+add_trigger(Interactables *ix, SDL_FRect box, int target)
+{
+    Interact_Cells *c = &ix->trigger_cells;
+    if (ix->built || c->count >= c->capacity) return -1;
+
+    ix->triggers[c->count] = (Trigger) {.target = target, .fired = 0};
+    c->box[c->count]       = box;
+
+    return c->count++;
+}
+
+Interactables*
+gen_test_interactables(Map *m)
+{
+    Interactables *ix = init_interactables(16);
+    if (ix == NULL) return NULL;
+
+    /*a switch and a pressure plate both working the door on the right*/
+    int door = add_interactable(ix, INT_DOOR, (SDL_Point) {15, 7}, -1);
+    add_interactable(ix, INT_SWITCH, (SDL_Point) {12, 7}, door);
+    add_interactable(ix, INT_CHEST, (SDL_Point) {3, 7}, -1);
+    add_trigger(ix, (SDL_FRect) {17 * TILE_SIZE, 7 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, door);
+
+    if (!build_interact_index(ix, m)) {
+        free_interactables(ix);
+        return NULL;
+    }
+
+    return ix;
+}
+
+bool
+build_interact_index(Interactables *ix, Map *m)
+{
+    ix->chunk_rows = m->chunk_rows;
+    ix->chunk_cols = m->chunk_cols;
+
+    if (!build_interact_cells(ix, &ix->object_cells) ||
+        !build_interact_cells(ix, &ix->trigger_cells)) {
+        return false;
+    }
+
+    sync_door_tiles(ix, m);
+
+    ix->built = true;
+    return true;
+}
+
+void
+sync_door_tiles(Interactables *ix, Map *m)
+{
+    if (ix == NULL) return;
+
+    /*closed doors are walls as far as everything else is concerned*/
+    for (int i = 0; i < ix->object_cells.count; i++) {
+        Interactable *o = &ix->objects[i];
+        if (o->kind == INT_DOOR) {
+            map_set_tile(m, o->tile.y, o->tile.x, o->on ? NO_TILE : WALL);
+        }
+    }
+}
+
+bool
+build_interact_cells(Interactables *ix, Interact_Cells *c)
+{
+    int chunks = ix->chunk_rows * ix->chunk_cols;
+    int i, r, col, total = 0;
+
+    c->start = calloc(chunks + 1, sizeof(int));
+    if (c->start == NULL) return false;
+
+    /*counting sort, one pass to size each chunk's run and one to fill it*/
+    for (i = 0; i < c->count; i++) {
+        SDL_Rect span = interact_chunk_span(ix, c->box[i]);
+        for (r = span.y; r < span.y + span.h; r++) {
+            for (col = span.x; col < span.x + span.w; col++) {
+                c->start[r * ix->chunk_cols + col + 1]++;
+                total++;
+            }
+        }
+    }
+    for (i = 0; i < chunks; i++) {
+        c->start[i + 1] += c->start[i];
+    }
+
+    c->items = malloc(sizeof(int) * (total > 0 ? total : 1));
+    int *fill = malloc(sizeof(int) * (chunks > 0 ? chunks : 1));
+    if (c->items == NULL || fill == NULL) {
+        free(fill);
+        return false;
+    }
+
+    for (i = 0; i < chunks; i++) {
+        fill[i] = c->start[i];
+    }
+    for (i = 0; i < c->count; i++) {
+        SDL_Rect span = interact_chunk_span(ix, c->box[i]);
+        for (r = span.y; r < span.y + span.h; r++) {
+            for (col = span.x; col < span.x + span.w; col++) {
+                c->items[fill[r * ix->chunk_cols + col]++] = i;
+            }
+        }
+    }
+
+    free(fill);
+    return true;
+}
+
+SDL_Rect
+interact_chunk_span(Interactables *ix, SDL_FRect box)
+{
+    float side = CHUNK_TILES * TILE_SIZE;
+    int left  = SDL_max((int) floorf(box.x / side), 0);
+    int top   = SDL_max((int) floorf(box.y / side), 0);
+    int right = SDL_min((int) floorf((box.x + box.w - 1) / side), ix->chunk_cols - 1);
+    int bot   = SDL_min((int) floorf((box.y + box.h - 1) / side), ix->chunk_rows - 1);
+
+    if (right < left || bot < top) return (SDL_Rect) {0, 0, 0, 0};
+
+    return (SDL_Rect) {left, top, right - left + 1, bot - top + 1};
+}
+
+int
+query_cells(Interactables *ix, Interact_Cells *c, SDL_FRect area, int *out, int max)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+    SDL_Rect span  = interact_chunk_span(ix, area);
+    int n = 0;
+
+    /*wrapping to 0 would match untouched stamps, so clear them once instead*/
+    if (++ix->query == 0) {
+        for (int i = 0; i < c->count; i++) {
+            c->stamp[i] = 0;
+        }
+        ix->query = 1;
+    }
+
+    for (int r = span.y; r < span.y + span.h; r++) {
+        for (int col = span.x; col < span.x + span.w; col++) {
+            int chunk = r * ix->chunk_cols + col;
+            for (int k = c->start[chunk]; k < c->start[chunk + 1] && n < max; k++) {
+                int i = c->items[k];
+                if (c->stamp[i] == ix->query) continue;
+                c->stamp[i] = ix->query;
+
+                /*strict, boxes that only share an edge don't count*/
+                SDL_FRect *b = &c->box[i];
+                if (b->x < area.x + area.w && area.x < b->x + b->w &&
+                    b->y < area.y + area.h && area.y < b->y + b->h) {
+                    out[n++] = i;
+                }
+            }
+        }
+    }
+
+    ix->queries++;
+    ix->query_ns += (SDL_GetPerformanceCounter() - start) * 1000000000u
+                    / SDL_GetPerformanceFrequency();
+
+    return n;
+}
+
+int
+query_interactables(Interactables *ix, SDL_FRect area, int *out, int max)
+{
+    return query_cells(ix, &ix->object_cells, area, out, max);
+}
+
+int
+query_triggers(Interactables *ix, SDL_FRect area, int *out, int max)
+{
+    return query_cells(ix, &ix->trigger_cells, area, out, max);
+}
+
+int
+interact_with(Interactables *ix, Map *m, Player *p)
+{
+    int found[8], best = -1;
+    float best_d = 0.0f;
+    SDL_FRect body = (SDL_FRect) {
+        .x = p->pos.x + p->physics.collisionY.x,
+        .y = p->pos.y + p->physics.collisionY.y,
+        .w = p->physics.collisionY.w,
+        .h = p->physics.collisionY.h,
+    };
+    SDL_FRect reach = (SDL_FRect) {
+        .x = body.x - INTERACT_REACH,
+        .y = body.y - INTERACT_REACH,
+        .w = body.w + 2 * INTERACT_REACH,
+        .h = body.h + 2 * INTERACT_REACH,
+    };
+
+    int n = query_interactables(ix, reach, found, 8);
+    for (int i = 0; i < n; i++) {
+        SDL_FRect *b = &ix->object_cells.box[found[i]];
+        float dx = (b->x + b->w / 2) - (body.x + body.w / 2);
+        float dy = (b->y + b->h / 2) - (body.y + body.h / 2);
+        if (best < 0 || dx * dx + dy * dy < best_d) {
+            best   = found[i];
+            best_d = dx * dx + dy * dy;
+        }
+    }
+
+    if (best >= 0) use_interactable(ix, m, best);
+    return best;
+}
+
+void
+set_interact_bodies(Interactables *ix, Player *p, Actor_Pool *ap)
+{
+    if (ix == NULL) return;
+
+    ix->player = p;
+    ix->actors = ap;
+}
+
+void
+use_interactable(Interactables *ix, Map *m, int id)
+{
+    if (id < 0 || id >= ix->object_cells.count) return;
+
+    Interactable *o = &ix->objects[id];
+    ix->uses++;
+
+    switch (o->kind) {
+        case INT_DOOR:
+            /*closing it would shut a wall on whoever stands in the way*/
+            if (o->on && door_blocked(ix, ix->object_cells.box[id])) break;
+            o->on = !o->on;
+            map_set_tile(m, o->tile.y, o->tile.x, o->on ? NO_TILE : WALL);
+            break;
+        case INT_CHEST:
+            o->on = true;
+            break;
+        case INT_SWITCH:
+            o->on = !o->on;
+            /*a switch wired to another switch only flips it, no chains*/
+            if (o->target >= 0 && o->target < ix->object_cells.count) {
+                if (ix->objects[o->target].kind == INT_SWITCH) {
+                    ix->objects[o->target].on = !ix->objects[o->target].on;
+                } else {
+                    use_interactable(ix, m, o->target);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+bool
+door_blocked(Interactables *ix, SDL_FRect door)
+{
+    Player *p = ix->player;
+
+    if (p != NULL) {
+        SDL_FRect body = (SDL_FRect) {
+            .x = p->pos.x + p->physics.collisionY.x,
+            .y = p->pos.y + p->physics.collisionY.y,
+            .w = p->physics.collisionY.w,
+            .h = p->physics.collisionY.h,
+        };
+        if (body.x < door.x + door.w && door.x < body.x + body.w &&
+            body.y < door.y + door.h && door.y < body.y + body.h) {
+            return true;
+        }
+    }
+
+    /*actors come from the chunk buckets around the door, not the pool*/
+    return actors_overlap(ix->actors, door);
+}
+
+void
+check_triggers(Interactables *ix, Map *m, Player *p)
+{
+    int found[MAX_BODY_TRIGGERS];
+    SDL_FRect body = (SDL_FRect) {
+        .x = p->pos.x + p->physics.collisionY.x,
+        .y = p->pos.y + p->physics.collisionY.y,
+        .w = p->physics.collisionY.w,
+        .h = p->physics.collisionY.h,
+    };
+
+    int n = query_triggers(ix, body, found, MAX_BODY_TRIGGERS);
+
+    /*volumes fire on the way in, standing in one does nothing more*/
+    for (int i = 0; i < n; i++) {
+        bool was_inside = false;
+        for (int k = 0; k < p->num_triggers && !was_inside; k++) {
+            was_inside = p->triggers[k] == found[i];
+        }
+        if (was_inside) continue;
+
+        Trigger *t = &ix->triggers[found[i]];
+        t->fired++;
+        use_interactable(ix, m, t->target);
+    }
+
+    for (int i = 0; i < n; i++) {
+        p->triggers[i] = found[i];
+    }
+    p->num_triggers = n;
+}
+
+void
+check_actor_triggers(Interactables *ix, Map *m, Actor_Pool *ap)
+{
+    /*sleeping actors haven't moved, so they can't have entered anything*/
+    for (int i = 0; i < ap->count; i++) {
+        if (ap->actors[i].tier != SIM_SLEEP) {
+            check_triggers(ix, m, ap->actors[i].body);
+        }
+    }
+}
+
+void
+draw_interactables(Game *g, Interactables *ix)
+{
+    static const SDL_Color colours[NUM_INTERACT_KINDS][2] = {
+        {{120, 72, 32, 255}, {60, 36, 16, 255}},
+        {{160, 120, 40, 255}, {90, 70, 30, 255}},
+        {{140, 40, 40, 255}, {40, 140, 40, 255}},
+    };
+    int found[64];
+    SDL_FRect view = (SDL_FRect) {g->camera.x, g->camera.y, G_WIDTH, G_HEIGHT};
+
+    /*no art for these in the sheet yet, flat boxes stand in*/
+    int n = query_interactables(ix, view, found, 64);
+    for (int i = 0; i < n; i++) {
+        Interactable *o = &ix->objects[found[i]];
+        SDL_FRect b = ix->object_cells.box[found[i]];
+        SDL_Color c = colours[o->kind][o->on];
+
+        b.x -= g->camera.x;
+        b.y -= g->camera.y;
+        if (o->kind != INT_DOOR) {
+            b.x += 3;
+            b.w -= 6;
+            b.y += b.h / 2;
+            b.h /= 2;
+        }
+
+        SDL_SetRenderDrawColor(g->renderer, c.r, c.g, c.b, c.a);
+        if (o->kind == INT_DOOR && o->on) {
+            SDL_RenderRect(g->renderer, &b);
+        } else {
+            SDL_RenderFillRect(g->renderer, &b);
+        }
+    }
+}
+
+void
+print_interact_stats(Interactables *ix)
+{
+    if (ix == NULL || ix->queries == 0) return;
+
+    printf("interact: %d objects, %d triggers, %llu queries at %.3f us avg, %llu uses\n",
+        ix->object_cells.count,
+        ix->trigger_cells.count,
+        (unsigned long long) ix->queries,
+        ix->query_ns / 1e3 / ix->queries,
+        (unsigned long long) ix->uses);
+}
+
+void
+free_interact_cells(Interact_Cells *c)
+{
+    free(c->box);
+    free(c->start);
+    free(c->items);
+    free(c->stamp);
+}
+
+void
+free_interactables(Interactables *ix)
+{
+    if (ix != NULL) {
+        printf("...freeing Interactables\n");
+        free_interact_cells(&ix->object_cells);
+        free_interact_cells(&ix->trigger_cells);
+        free(ix->objects);
+        free(ix->triggers);
+        free(ix);
+    }
+}
@@ -0,0 +1,277 @@
+#include "caves.h"
+
+//::light
+Lighting*
+init_lighting(Game *g, Map *m, uint8_t ambient)
+{
+    Lighting *l;
+    int side = 2 * LIGHT_MAX_RADIUS + 1;
+
+    l = malloc(sizeof(Lighting));
+    if (l == NULL) return NULL;
+
+    l->rows       = m->rows;
+    l->cols       = m->cols;
+    l->ambient    = ambient;
+    l->level      = malloc(sizeof(uint8_t) * m->rows * m->cols);
+    l->pixels     = malloc(sizeof(Uint32) * m->rows * m->cols);
+    l->queue      = malloc(sizeof(int) * side * side);
+    l->steps      = malloc(sizeof(int) * side * side);
+    l->texture    = NULL;
+    l->map_seq    = m->edit_seq;
+    l->dirty      = true;
+    l->dirty_rect = (SDL_Rect) {0, 0, m->cols, m->rows};
+    l->version    = 0;
+
+    for (int i = 0; i < MAX_LIGHTS; i++) {
+        l->lights[i] = (Light) {.active = false, .contrib = NULL};
+    }
+
+    if (l->level == NULL || l->pixels == NULL || l->queue == NULL || l->steps == NULL) {
+        free_lighting(l);
+        return NULL;
+    }
+
+    /*one texel per tile, linear filtering turns it into a smooth falloff*/
+    if (g->renderer != NULL) {
+        l->texture = SDL_CreateTexture(g->renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING,
+            m->cols,
+            m->rows);
+    }
+    if (l->texture != NULL) {
+        SDL_SetTextureScaleMode(l->texture, SDL_SCALEMODE_LINEAR);
+        SDL_SetTextureBlendMode(l->texture, SDL_BLENDMODE_MOD);
+    }
+
+    return l;
+}
+
+int
+add_light(Lighting *l, Map *m, SDL_Point tile, int radius)
+{
+    int side;
+    radius = radius > LIGHT_MAX_RADIUS ? LIGHT_MAX_RADIUS : radius;
+    side   = 2 * radius + 1;
+
+    for (int i = 0; i < MAX_LIGHTS; i++) {
+        Light *lt = &l->lights[i];
+        if (lt->active) continue;
+
+        lt->contrib = malloc(sizeof(uint8_t) * side * side);
+        if (lt->contrib == NULL) return -1;
+
+        lt->active = true;
+        lt->tile   = tile;
+        lt->radius = radius;
+        compute_light(l, m, lt);
+        mark_light_dirty(l, tile, radius);
+        return i;
+    }
+
+    return -1;
+}
+
+void
+move_light(Lighting *l, Map *m, int id, SDL_Point tile)
+{
+    if (id < 0 || id >= MAX_LIGHTS) return;
+
+    Light *lt = &l->lights[id];
+    if (!lt->active || (lt->tile.x == tile.x && lt->tile.y == tile.y)) return;
+
+    mark_light_dirty(l, lt->tile, lt->radius);
+    lt->tile = tile;
+    compute_light(l, m, lt);
+    mark_light_dirty(l, lt->tile, lt->radius);
+}
+
+void
+remove_light(Lighting *l, int id)
+{
+    if (id < 0 || id >= MAX_LIGHTS || !l->lights[id].active) return;
+
+    Light *lt = &l->lights[id];
+    mark_light_dirty(l, lt->tile, lt->radius);
+    free(lt->contrib);
+    lt->contrib = NULL;
+    lt->active  = false;
+}
+
+void
+compute_light(Lighting *l, Map *m, Light *lt)
+{
+    int r = lt->radius, side = 2 * r + 1;
+    int head = 0, tail = 0;
+    static const int d_row[4] = {-1, 1, 0, 0};
+    static const int d_col[4] = {0, 0, -1, 1};
+
+    for (int i = 0; i < side * side; i++) {
+        lt->contrib[i] = 0;
+        l->steps[i]    = -1;
+    }
+
+    if (tile_is_solid(m, lt->tile.y, lt->tile.x)) return;
+
+    /*bfs out from the source, walls take light but don't pass it on*/
+    l->steps[r * side + r] = 0;
+    l->queue[tail++]       = r * side + r;
+
+    while (head < tail) {
+        int cur  = l->queue[head++];
+        int step = l->steps[cur];
+        int lr   = cur / side, lc = cur % side;
+        int row  = lt->tile.y - r + lr, col = lt->tile.x - r + lc;
+
+        lt->contrib[cur] = (uint8_t) (255 * (r + 1 - step) / (r + 1));
+
+        if (step >= r || tile_is_solid(m, row, col)) continue;
+
+        for (int d = 0; d < 4; d++) {
+            int nr = lr + d_row[d], nc = lc + d_col[d];
+            int n_row = row + d_row[d], n_col = col + d_col[d];
+            if (nr < 0 || nr >= side || nc < 0 || nc >= side) continue;
+            if (n_row < 0 || n_row >= l->rows || n_col < 0 || n_col >= l->cols) continue;
+            if (l->steps[nr * side + nc] >= 0) continue;
+
+            l->steps[nr * side + nc] = step + 1;
+            l->queue[tail++]         = nr * side + nc;
+        }
+    }
+}
+
+void
+mark_light_dirty(Lighting *l, SDL_Point tile, int radius)
+{
+    SDL_Rect r = (SDL_Rect) {
+        .x = tile.x - radius,
+        .y = tile.y - radius,
+        .w = 2 * radius + 1,
+        .h = 2 * radius + 1,
+    };
+
+    if (l->dirty) {
+        int x0 = SDL_min(l->dirty_rect.x, r.x), y0 = SDL_min(l->dirty_rect.y, r.y);
+        int x1 = SDL_max(l->dirty_rect.x + l->dirty_rect.w, r.x + r.w);
+        int y1 = SDL_max(l->dirty_rect.y + l->dirty_rect.h, r.y + r.h);
+        r = (SDL_Rect) {x0, y0, x1 - x0, y1 - y0};
+    }
+
+    l->dirty      = true;
+    l->dirty_rect = r;
+}
+
+void
+light_sync_map(Lighting *l, Map *m)
+{
+    uint32_t pending = m->edit_seq - l->map_seq;
+    int i;
+
+    if (pending == 0) return;
+
+    for (i = 0; i < MAX_LIGHTS; i++) {
+        Light *lt = &l->lights[i];
+        if (!lt->active) continue;
+
+        bool touched = pending > MAP_EDIT_LOG;
+        for (uint32_t s = l->map_seq; !touched && s != m->edit_seq; s++) {
+            SDL_Point e = m->edit_log[s % MAP_EDIT_LOG];
+            touched = abs(e.x - lt->tile.x) <= lt->radius && abs(e.y - lt->tile.y) <= lt->radius;
+        }
+
+        if (touched) {
+            compute_light(l, m, lt);
+            mark_light_dirty(l, lt->tile, lt->radius);
+        }
+    }
+
+    l->map_seq = m->edit_seq;
+}
+
+void
+update_light_map(Lighting *l)
+{
+    int row, col, i;
+
+    if (!l->dirty) return;
+    l->dirty = false;
+
+    int x0 = SDL_max(l->dirty_rect.x, 0), y0 = SDL_max(l->dirty_rect.y, 0);
+    int x1 = SDL_min(l->dirty_rect.x + l->dirty_rect.w, l->cols);
+    int y1 = SDL_min(l->dirty_rect.y + l->dirty_rect.h, l->rows);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    for (row = y0; row < y1; row++) {
+        for (col = x0; col < x1; col++) {
+            l->level[row * l->cols + col] = l->ambient;
+        }
+    }
+
+    for (i = 0; i < MAX_LIGHTS; i++) {
+        Light *lt = &l->lights[i];
+        if (!lt->active) continue;
+
+        int side = 2 * lt->radius + 1;
+        int lx0 = SDL_max(x0, lt->tile.x - lt->radius), lx1 = SDL_min(x1, lt->tile.x + lt->radius + 1);
+        int ly0 = SDL_max(y0, lt->tile.y - lt->radius), ly1 = SDL_min(y1, lt->tile.y + lt->radius + 1);
+
+        for (row = ly0; row < ly1; row++) {
+            uint8_t *src = &lt->contrib[(row - lt->tile.y + lt->radius) * side];
+            uint8_t *dst = &l->level[row * l->cols];
+            for (col = lx0; col < lx1; col++) {
+                uint8_t v = src[col - lt->tile.x + lt->radius];
+                dst[col] = v > dst[col] ? v : dst[col];
+            }
+        }
+    }
+
+    for (row = y0; row < y1; row++) {
+        for (col = x0; col < x1; col++) {
+            Uint32 v = l->level[row * l->cols + col];
+            l->pixels[row * l->cols + col] = 0xFF000000u | v << 16 | v << 8 | v;
+        }
+    }
+
+    l->version++;
+    if (l->texture != NULL) {
+        SDL_Rect up = (SDL_Rect) {x0, y0, x1 - x0, y1 - y0};
+        SDL_UpdateTexture(l->texture,
+            &up,
+            &l->pixels[y0 * l->cols + x0],
+            l->cols * sizeof(Uint32));
+    }
+}
+
+void
+draw_lighting(Game *g, Lighting *l)
+{
+    if (l->texture == NULL) return;
+
+    /*with one texel per tile, texel centres land on tile centres*/
+    SDL_FRect dest = (SDL_FRect) {
+        .x = -g->camera.x,
+        .y = -g->camera.y,
+        .w = l->cols * TILE_SIZE,
+        .h = l->rows * TILE_SIZE,
+    };
+
+    SDL_RenderTexture(g->renderer, l->texture, NULL, &dest);
+}
+
+void
+free_lighting(Lighting *l)
+{
+    if (l != NULL) {
+        printf("...freeing Lighting\n");
+        for (int i = 0; i < MAX_LIGHTS; i++) {
+            free(l->lights[i].contrib);
+        }
+        if (l->texture != NULL) SDL_DestroyTexture(l->texture);
+        free(l->level);
+        free(l->pixels);
+        free(l->queue);
+        free(l->steps);
+        free(l);
+    }
+}
@@ -5,14 +5,41 @@
 int
 main(int argc, char *argv[])
 {
-    (void)argc;(void)argv;
-
     Game   *game;
     Player *player;
     Map    *test_map;
     Sprite *map_sprites;
+    Nav    *nav;
+    Lighting *lighting;
+    Particles *particles;
+    Audio  *audio;
+    Actor_Pool *actors;
+    Interactables *interact;
+    Save_State *save_state;
+    Stress *stress;
+    Watcher *watcher;
+    int    player_light;
+    int    stress_n = 0;
 
     uint64_t last_update_ms;
+    bool     bench = false, json = false, render_bench = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--bench") == 0) bench = true;
+        if (SDL_strcmp(argv[i], "--json") == 0)  json  = true;
+        if (SDL_strcmp(argv[i], "--render-bench") == 0) render_bench = true;
+        if (SDL_strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stress_n = SDL_atoi(argv[++i]);
+        }
+    }
+    /*headless, nothing below needs a window*/
+    if (bench) return run_benchmarks(json);
+    if (render_bench) {
+        int ok = run_render_bench();
+        IMG_Quit();
+        SDL_Quit();
+        return ok;
+    }
 
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         printf("SDL couldn't init: %s\n", SDL_GetError());
@@ -35,18 +62,37 @@ main(int argc, char *argv[])
     }
     set_game_resolution(game, G_WIDTH, G_HEIGHT, SDL_LOGICAL_PRESENTATION_INTEGER_SCALE);
 
-    game->spritesheet = load_spritesheet_png(game, "./assets/tilesheet.png");
+    game->textures    = init_texture_manager(game->renderer, TEXTURE_BUDGET);
+    game->sheet       = register_texture(game->textures, SHEET_PATH);
+    game->spritesheet = get_texture(game->textures, game->sheet);
     if (game->spritesheet == NULL) {
         printf("Couldn't load spritesheet\n");
         game->running = false;
     }
 
-    SDL_SetTextureScaleMode(game->spritesheet, SDL_SCALEMODE_NEAREST);
-
     player      = load_player_struct();
     map_sprites = init_map_sprites();
 
-    test_map = gen_test_map();
+    test_map = map_load(LEVEL_PATH);
+    if (test_map == NULL) test_map = gen_test_map();
+    bind_level_atlases(game->textures, test_map, game->sheet);
+    gen_test_platforms(test_map);
+    interact = gen_test_interactables(test_map);
+    save_state = init_save_state(test_map);
+    nav      = nav_build(test_map, &player->physics);
+    lighting = init_lighting(game, test_map, 40);
+    player_light = add_light(lighting, test_map, player_tile(player), 7);
+    particles    = init_particles(4096, true);
+    audio        = init_audio();
+    actors       = init_actor_pool(test_map, stress_n > 0 ? stress_n : 256);
+    stress       = stress_n > 0 ? init_stress(actors, test_map, stress_n) : NULL;
+    if (stress == NULL) populate_actors(actors, test_map, 16);
+    set_interact_bodies(interact, player, actors);
+
+    watcher = init_watcher();
+    add_watch(watcher, SHEET_PATH, WATCH_TEXTURE, game->sheet);
+    add_watch(watcher, LEVEL_PATH, WATCH_LEVEL, -1);
+    start_watcher(watcher);
 
     last_update_ms = SDL_GetTicks();
 
@@ -54,14 +100,21 @@ main(int argc, char *argv[])
         uint64_t start_ms = SDL_GetTicks(),
                  current_time_ms,
                  elapsed_time_ms;
+        uint64_t frame_start = SDL_GetPerformanceCounter(), sim_start, draw_start;
         SDL_Event event;
-        
-        SDL_SetRenderDrawColor(game->renderer, 5, 5, 5, 255);
-        SDL_RenderClear(game->renderer);
+        bool have_event = false;
 
         begin_new_fame(game);
 
-        while (SDL_PollEvent(&event)) {
+        /*nothing has changed on screen for a while and no key is down, so
+          sleep in the event queue instead of spinning at full rate*/
+        if (game->idle_frames >= IDLE_FRAMES && !any_key_held(game)) {
+            have_event     = SDL_WaitEventTimeout(&event, IDLE_WAIT_MS);
+            last_update_ms = SDL_GetTicks();
+        }
+
+        while (have_event || SDL_PollEvent(&event)) {
+            have_event = false;
             switch (event.type) {
                 case SDL_EVENT_QUIT:
                     game->running = false;
@@ -69,6 +122,15 @@ main(int argc, char *argv[])
                 case SDL_EVENT_KEY_DOWN:
                     if (event.key.key == SDLK_ESCAPE) {
                         game->running = false;
+                    } else if (event.key.key == SDLK_F2) {
+                        toggle_editor(game);
+                    } else if (event.key.key == SDLK_F5) {
+                        map_save(test_map, LEVEL_PATH);
+                    } else if (event.key.key == SDLK_F6) {
+                        save_game(save_state, test_map, player, interact, SAVE_PATH);
+                    } else if (event.key.key == SDLK_F9) {
+                        load_game(save_state, test_map, player, interact, SAVE_PATH);
+                        update_camera(game, player, test_map);
                     } else {
                         key_down_event(game, keycode_to_keys(event.key.key));
                     }
@@ -76,6 +138,19 @@ main(int argc, char *argv[])
                 case SDL_EVENT_KEY_UP:
                     key_up_event(game, keycode_to_keys(event.key.key));
                     break;
+                case SDL_EVENT_MOUSE_BUTTON_DOWN:
+                case SDL_EVENT_MOUSE_BUTTON_UP:
+                case SDL_EVENT_MOUSE_MOTION:
+                    editor_event(game, test_map, &event);
+                    break;
+                case SDL_EVENT_RENDER_TARGETS_RESET:
+                case SDL_EVENT_RENDER_DEVICE_RESET:
+                    map_invalidate_chunks(test_map);
+                    game->frame_valid = false;
+                    break;
+                case SDL_EVENT_WINDOW_EXPOSED:
+                    game->frame_valid = false;
+                    break;
                 default:
                     break;
             }
@@ -83,19 +158,105 @@ main(int argc, char *argv[])
 
         current_time_ms = SDL_GetTicks();
         elapsed_time_ms = current_time_ms - last_update_ms;
+        /*fixed steps, so every stage simulates the same amount of game time*/
+        if (stress != NULL) elapsed_time_ms = STRESS_STEP_MS;
+        sim_start = SDL_GetPerformanceCounter();
+
+        apply_reloads(game, watcher, test_map, interact);
+        poll_save(save_state);
+        apply_pending_chunks(save_state, test_map, map_visible_chunks(game, test_map));
+        update_platforms(test_map->platforms, elapsed_time_ms);
+        player_update(&game->m_buff, player, elapsed_time_ms, test_map);
+        update_camera(game, player, test_map);
+        update_actors(game, actors, test_map, nav, elapsed_time_ms);
+        nav_update(nav, test_map, player->pos, NAV_BUDGET);
+
+        if (player->events & EV_INTERACT) {
+            interact_with(interact, test_map, player);
+        }
+        check_triggers(interact, test_map, player);
+        check_actor_triggers(interact, test_map, actors);
 
-        player_update(game, player, elapsed_time_ms, test_map);
+        SDL_FPoint feet = {player->pos.x + TILE_SIZE / 2, player->pos.y + TILE_SIZE - 1};
+        if (player->events & EV_JUMPED) {
+            emit_particles(particles, feet, 12, 0.06f, 350.0f);
+            play_sound(audio, SFX_JUMP, 0.5f);
+        }
+        if (player->events & EV_LANDED) {
+            emit_particles(particles, feet, 24, 0.08f, 450.0f);
+            play_sound(audio, SFX_LAND, 0.6f);
+        }
+        if (player->events & EV_HAZARD) {
+            emit_particles(particles, feet, 32, 0.1f, 500.0f);
+        }
+        update_particles(particles, test_map, elapsed_time_ms);
+
+        light_sync_map(lighting, test_map);
+        move_light(lighting, test_map, player_light, player_tile(player));
+        update_light_map(lighting);
 
         last_update_ms = current_time_ms;
-        
-        draw_player(game, player);
-        draw_map(game, map_sprites, test_map);
 
-        SDL_RenderPresent(game->renderer);
+        Frame_State frame = (Frame_State) {
+            .player_x   = (int) round(player->pos.x),
+            .player_y   = (int) round(player->pos.y),
+            .player_src = player->curr_sprite->source,
+            .map_seq    = test_map->edit_seq,
+            .light_seq  = lighting->version,
+            .particles  = particles->count,
+            .camera_x   = (int) game->camera.x,
+            .camera_y   = (int) game->camera.y,
+            .actors     = actors_signature(actors),
+            .platforms  = platforms_signature(game, test_map->platforms),
+            .cursor     = editor_cursor(game, test_map),
+        };
+
+        /*under stress every frame is drawn so the draw column means something*/
+        if (stress != NULL) game->frame_valid = false;
+        draw_start = SDL_GetPerformanceCounter();
+
+        if (frame_changed(game, &frame)) {
+            begin_texture_frame(game->textures);
+            game->spritesheet = get_texture(game->textures, game->sheet);
+
+            SDL_SetRenderDrawColor(game->renderer, 5, 5, 5, 255);
+            SDL_RenderClear(game->renderer);
+
+            draw_actors(game, actors);
+            draw_player(game, player);
+            draw_map(game, map_sprites, test_map);
+            draw_platforms(game, test_map->platforms);
+            draw_interactables(game, interact);
+            draw_particles(game, particles);
+            draw_lighting(game, lighting);
+            draw_editor(game, test_map);
+
+            SDL_RenderPresent(game->renderer);
+        }
 
-        force_fps(50, start_ms);
+        if (stress != NULL) {
+            uint64_t end = SDL_GetPerformanceCounter();
+            if (!stress_frame(stress, actors, test_map, draw_start - sim_start, end - draw_start, end - frame_start)) {
+                game->running = false;
+            }
+        } else {
+            force_fps(50, start_ms);
+        }
     }
 
+    free_watcher(watcher);
+    print_frame_stats(game);
+    print_editor_stats(&game->editor);
+    print_sim_stats(actors);
+    free_stress(stress);
+    free_actor_pool(actors);
+    print_interact_stats(interact);
+    free_interactables(interact);
+    free_save_state(save_state);
+    free_audio(audio);
+    free_particles(particles);
+    free_lighting(lighting);
+    free_nav(nav);
     free_map(map_sprites, test_map);
     free_player_struct(player);
     free_game_struct(game);
@@ -117,10 +278,21 @@ init_game_struct(char* name, int w, int h)
     g->window      = NULL;
     g->renderer    = NULL;
     g->spritesheet = NULL;
+    g->textures    = NULL;
+    g->sheet       = -1;
+    g->camera      = (SDL_FPoint) {0, 0};
     g->running     = false;
     g->width       = w;
     g->height      = h;
 
+    g->editor = (Editor) {.active = false, .brush = -1, .cursor = {-1, -1}};
+
+    g->frame_valid    = false;
+    g->idle_frames    = 0;
+    g->frames_drawn   = 0;
+    g->frames_skipped = 0;
+    g->draw_calls     = 0;
+
     for (int i = 0; i < NUM_KEYS; i++) {
         g->m_buff.pressed_keys[i] = false;
         g->m_buff.held_keys[i] = false;
@@ -141,17 +313,6 @@ set_game_resolution(Game *g, int r_w, int r_h, SDL_RendererLogicalPresentation l
     );
 }
 
-SDL_Texture*
-load_spritesheet_png(Game *g, char *filepath)
-{
-    SDL_Texture *s;
-
-    if (g->renderer == NULL) return NULL;
-    s = IMG_LoadTexture(g->renderer, filepath);
-
-    return s;
-}
-
 int keycode_to_keys(SDL_Keycode k) {
     switch (k) {
         case SDLK_LEFT:
@@ -189,21 +350,89 @@ void key_up_event(Game* g, int key) {
     g->m_buff.held_keys[key] = false;
 }
 
-bool was_key_pressed(Game* g, int key) {
-    return g->m_buff.pressed_keys[key];
+bool was_key_pressed(Move_Buffer* mb, int key) {
+    return mb->pressed_keys[key];
 }
 
-bool was_key_released(Game* g, int key) {
-    return g->m_buff.released_keys[key];
+bool was_key_released(Move_Buffer* mb, int key) {
+    return mb->released_keys[key];
 }
 
-bool is_key_held(Game* g, int key) {
-    return g->m_buff.held_keys[key];
+bool is_key_held(Move_Buffer* mb, int key) {
+    return mb->held_keys[key];
+}
+
+void
+update_camera(Game *g, Player *p, Map *m)
+{
+    /*follow the player, clamped so the view never leaves the map*/
+    float max_x = (float) (m->cols * TILE_SIZE - G_WIDTH);
+    float max_y = (float) (m->rows * TILE_SIZE - G_HEIGHT);
+    float x = p->pos.x + TILE_SIZE / 2 - G_WIDTH / 2;
+    float y = p->pos.y + TILE_SIZE / 2 - G_HEIGHT / 2;
+
+    g->camera.x = roundf(fmaxf(0.0f, fminf(x, max_x)));
+    g->camera.y = roundf(fmaxf(0.0f, fminf(y, max_y)));
+}
+
+bool
+any_key_held(Game* g)
+{
+    for (int i = 0; i < NUM_KEYS; i++) {
+        if (g->m_buff.held_keys[i]) return true;
+    }
+    return false;
+}
+
+bool
+frame_changed(Game* g, Frame_State *now)
+{
+    Frame_State *last = &g->last_frame;
+    bool changed = !g->frame_valid ||
+        now->player_x     != last->player_x     ||
+        now->player_y     != last->player_y     ||
+        now->player_src.x != last->player_src.x ||
+        now->player_src.y != last->player_src.y ||
+        now->map_seq      != last->map_seq      ||
+        now->light_seq    != last->light_seq    ||
+        now->camera_x     != last->camera_x     ||
+        now->camera_y     != last->camera_y     ||
+        now->actors       != last->actors       ||
+        now->platforms    != last->platforms    ||
+        now->cursor       != last->cursor       ||
+        now->particles    != 0                  ||
+        last->particles   != 0;
+
+    if (changed) {
+        g->last_frame  = *now;
+        g->frame_valid = true;
+        g->idle_frames = 0;
+        g->frames_drawn++;
+    } else {
+        g->idle_frames++;
+        g->frames_skipped++;
+    }
+
+    return changed;
+}
+
+void
+print_frame_stats(Game* g)
+{
+    uint64_t total = g->frames_drawn + g->frames_skipped;
+    if (total == 0) return;
+
+    printf("frames: %llu drawn, %llu skipped as unchanged (%.1f%%)\n",
+        (unsigned long long) g->frames_drawn,
+        (unsigned long long) g->frames_skipped,
+        100.0 * g->frames_skipped / total);
 }
 
 void
 free_game_struct(Game *g)
 {
+    /*the manager owns the spritesheet, and textures go before their renderer*/
+    free_texture_manager(g->textures);
     if (g->window != NULL) {
         printf("...freeing Window\n");
         SDL_DestroyWindow(g->window);
@@ -212,10 +441,6 @@ free_game_struct(Game *g)
         printf("...freeing Renderer\n");
         SDL_DestroyRenderer(g->renderer);
     }
-    if (g->spritesheet != NULL) {
-        printf("...freeing spritesheet Texture\n");
-        SDL_DestroyTexture(g->spritesheet);
-    }
     if (g != NULL) {
         printf("...freeing Game struct\n");
         free(g);
@@ -249,12 +474,17 @@ load_player_struct(void)
     p->dir         = LEFT;
     p->looking     = HORIZONTAL;
     p->curr_sprite = &p->sprites[L_IDLE_H];
+    p->events      = 0;
+    p->num_triggers = 0;
     p->pos.x       = (MAP_COLS / 2) * TILE_SIZE;
     p->pos.y       = 0;
     p->physics     = (Physics) {
                 .interacting  = false,
                 .on_ground    = false,
                 .jump_active  = false,
+                .platform     = -1,
+                .carried_from = {0.0f, 0.0f},
+                .grip         = 1.0f,
                 .acc_x        = 0,
                 .walking_acc  = 0.00083007812,
                 .max_speed_x  = 0.15859375 / 2,
@@ -335,42 +565,53 @@ load_player_sprite(int dir, int state, int looking)
 }
 
 void
-player_update(Game* g, Player *p, uint64_t e_t, Map *m)
+player_update(Move_Buffer* mb, Player *p, uint64_t e_t, Map *m)
 {
+    p->events = 0;
     set_state(p);
     change_sprite(p);
-    handle_player_input(g, p);
+    handle_player_input(mb, p);
     update_player_pos(p, e_t, m);
     tick_animation(p, e_t);
     return;
 }
 
 void
-handle_player_input(Game* g, Player *p)
+player_update_physics(Move_Buffer* mb, Player *p, uint64_t e_t, Map *m)
+{
+    /*player_update without the sprite and animation steps*/
+    p->events = 0;
+    set_state(p);
+    handle_player_input(mb, p);
+    update_player_pos(p, e_t, m);
+}
+
+void
+handle_player_input(Move_Buffer* mb, Player *p)
 {
-    if (is_key_held(g, K_LEFT) && is_key_held(g, K_RIGHT)) {
+    if (is_key_held(mb, K_LEFT) && is_key_held(mb, K_RIGHT)) {
         stop_moving(p);
-    } else if (is_key_held(g, K_LEFT)) {
+    } else if (is_key_held(mb, K_LEFT)) {
          start_moving_left(p);
-    } else if (is_key_held(g, K_RIGHT)) {
+    } else if (is_key_held(mb, K_RIGHT)) {
          start_moving_right(p);
     } else {
         stop_moving(p);
     }
 
-    if (is_key_held(g, K_UP) && is_key_held(g, K_DOWN)) {
+    if (is_key_held(mb, K_UP) && is_key_held(mb, K_DOWN)) {
         look_horizontal(p);
-    } else if (is_key_held(g, K_UP)) {
+    } else if (is_key_held(mb, K_UP)) {
         look_up(p);
-    } else if (is_key_held(g, K_DOWN)) {
+    } else if (is_key_held(mb, K_DOWN)) {
         look_down(p);
     } else {
         look_horizontal(p);
     }
 
-    if (was_key_pressed(g, K_Z)) {
+    if (was_key_pressed(mb, K_Z)) {
         start_jump(p);
-    } else if (was_key_released(g, K_Z)) {
+    } else if (was_key_released(mb, K_Z)) {
         stop_jump(p);
     }
 
@@ -381,6 +622,7 @@ void
 set_state(Player *p)
 {
     if (p->physics.interacting) {
+        if (p->state != INTERACTING) p->events |= EV_INTERACT;
         p->state = INTERACTING;
     } else if (p->physics.on_ground) {
         if (p->physics.acc_x < 0 || p->physics.acc_x > 0) {
@@ -465,6 +707,7 @@ start_jump(Player *p)
     p->physics.jump_active = true;
     if (p->physics.on_ground) {
         p->physics.vel_y = (-1 * p->physics.jump_speed);
+        p->events |= EV_JUMPED;
     }
 }
 
@@ -477,6 +720,7 @@ stop_jump(Player *p)
 void
 update_player_pos(Player *p, uint64_t e_t, Map* m)
 {
+    carry_rider(p, m);
     update_player_X(p, e_t, m);
     update_player_Y(p, e_t, m);
 }
@@ -501,45 +745,45 @@ update_player_X(Player *p, uint64_t e_t, Map* m)
         p->physics.vel_x = fminf(p->physics.vel_x, p->physics.max_speed_x);
     } else if (p->physics.on_ground) {
         p->physics.vel_x = p->physics.vel_x > 0.0f ? 
-            fmaxf(0.0f, p->physics.vel_x - p->physics.friction * e_t) : 
-            fminf(0.0f, p->physics.vel_x + p->physics.friction * e_t);
+            fmaxf(0.0f, p->physics.vel_x - p->physics.friction * p->physics.grip * e_t) : 
+            fminf(0.0f, p->physics.vel_x + p->physics.friction * p->physics.grip * e_t);
     }
 
     int delta = p->physics.vel_x * e_t;
 
     if (delta > 0) {
         r = right_collision(p, delta);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 1, 0);
 
         if (info.collided) {
-            p->pos.x = info.col * TILE_SIZE - rect_right(p->physics.collisionX);
+            p->pos.x = info.rect.x - rect_right(p->physics.collisionX);
             p->physics.vel_x = 0.0f;
         } else {
             p->pos.x += delta;
         }
 
         r = left_collision(p, 0);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, -1, 0);
 
         if (info.collided) {
-            p->pos.x = info.col * TILE_SIZE + rect_right(p->physics.collisionX);
+            p->pos.x = info.rect.x + info.rect.w - rect_left(p->physics.collisionX);
         }
     } else {
         r = left_collision(p, delta);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, -1, 0);
 
         if (info.collided) {
-            p->pos.x = info.col * TILE_SIZE + rect_right(p->physics.collisionX);
+            p->pos.x = info.rect.x + info.rect.w - rect_left(p->physics.collisionX);
             p->physics.vel_x = 0.0f;
         } else {
             p->pos.x += delta;
         }
 
         r = right_collision(p, 0);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 1, 0);
 
         if (info.collided) {
-            p->pos.x = info.col * TILE_SIZE - rect_right(p->physics.collisionX);
+            p->pos.x = info.rect.x - rect_right(p->physics.collisionX);
         }        
     }
 }
@@ -549,6 +793,7 @@ update_player_Y(Player *p, uint64_t e_t, Map* m)
 {
     SDL_FRect r;
     Collision_Info info;
+    bool was_on_ground = p->physics.on_ground;
 
     float gravity = p->physics.jump_active && p->physics.vel_y < 0.0f ? 
             p->physics.jump_gravity : p->physics.gravity;
@@ -556,46 +801,91 @@ update_player_Y(Player *p, uint64_t e_t, Map* m)
     p->physics.vel_y = fminf(p->physics.vel_y + gravity * e_t, p->physics.max_speed_y);
 
     int delta = p->physics.vel_y * e_t;
+    int ground = -1, ground_tile = -1;
 
     if (delta > 0) {
         r = bot_collision(p, delta);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 0, delta);
 
         if (info.collided) {
-            p->pos.y = info.row * TILE_SIZE - rect_bot(p->physics.collisionY);
+            p->pos.y = info.rect.y - rect_bot(p->physics.collisionY);
             p->physics.vel_y = 0.0f;
             p->physics.on_ground = true;
+            ground = info.platform;
+            ground_tile = info.tile;
         } else {
             p->pos.y += delta;
             p->physics.on_ground = false;
         }
 
         r = top_collision(p, 0);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 0, -1);
 
         if (info.collided) {
-            p->pos.y = info.row * TILE_SIZE + p->physics.collisionY.h;
+            p->pos.y = info.rect.y + info.rect.h - rect_top(p->physics.collisionY);
         }
     } else {
         r = top_collision(p, delta);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 0, -1);
 
         if (info.collided) {
-            p->pos.y = info.row * TILE_SIZE + p->physics.collisionY.h;
+            p->pos.y = info.rect.y + info.rect.h - rect_top(p->physics.collisionY);
             p->physics.vel_y = 0.0f;
         } else {
             p->pos.y += delta;
             p->physics.on_ground = false;
         }
 
+        /*while rising only solid tiles can be underfoot, one-way tops and
+          slopes are being jumped through*/
         r = bot_collision(p, 0);
-        info = get_wall_collision_coords(m, r);
+        info = get_solid_collision(m, r, 0, delta < 0 ? 0 : 1);
 
         if (info.collided) {
-            p->pos.y = info.row * TILE_SIZE - rect_bot(p->physics.collisionY);
+            p->pos.y = info.rect.y - rect_bot(p->physics.collisionY);
             p->physics.on_ground = true;
+            ground = info.platform;
+            ground_tile = info.tile;
         }
     } 
+
+    /*walking down a slope steps the body off the surface, pull it back on
+      instead of letting it fall for a few frames*/
+    if (was_on_ground && !p->physics.on_ground && p->physics.vel_y >= 0.0f) {
+        r = bot_collision(p, SLOPE_SNAP);
+        info = get_solid_collision(m, r, 0, SLOPE_SNAP);
+        if (info.collided && info.tile >= 0 && (tile_props[info.tile].flags & TF_SLOPE)) {
+            p->pos.y = info.rect.y - rect_bot(p->physics.collisionY);
+            p->physics.vel_y = 0.0f;
+            p->physics.on_ground = true;
+            ground_tile = info.tile;
+        }
+    }
+
+    /*one lookup covers whatever the ground tile does to the body*/
+    if (ground_tile >= 0) {
+        const Tile_Props *tp = &tile_props[ground_tile];
+        p->physics.grip = tp->friction;
+        if (tp->flags & TF_HAZARD) {
+            p->events |= EV_HAZARD;
+            p->physics.vel_y     = -p->physics.jump_speed;
+            p->physics.on_ground = false;
+        }
+    } else if (p->physics.on_ground) {
+        p->physics.grip = 1.0f;
+    }
+
+    /*remembered so the next update can carry the body along with it*/
+    p->physics.platform = p->physics.on_ground ? ground : -1;
+    if (ground >= 0) {
+        SDL_FRect box = m->platforms->list[ground].box;
+        p->physics.carried_from = (SDL_FPoint) {box.x, box.y};
+        stand_on_platform(m->platforms, ground);
+    }
+
+    if (!was_on_ground && p->physics.on_ground) {
+        p->events |= EV_LANDED;
+    }
 }
 
 SDL_FRect
@@ -671,12 +961,21 @@ tick_animation(Player *p, uint64_t e_t)
     }
 }
 
+SDL_Point
+player_tile(Player *p)
+{
+    return (SDL_Point) {
+        .x = (int) floorf((p->pos.x + TILE_SIZE / 2) / TILE_SIZE),
+        .y = (int) floorf((p->pos.y + TILE_SIZE / 2) / TILE_SIZE),
+    };
+}
+
 void
 draw_player(Game *g, Player *p)
 {
     SDL_FRect dest = (SDL_FRect) {
-        .x = round(p->pos.x),
-        .y = round(p->pos.y),
+        .x = round(p->pos.x - g->camera.x),
+        .y = round(p->pos.y - g->camera.y),
         .w = 16.0,
         .h = 16.0
     };
@@ -686,6 +985,7 @@ draw_player(Game *g, Player *p)
         &p->curr_sprite->source,
         &dest
     );
+    g->draw_calls++;
 
     return;
 }
@@ -700,14 +1000,34 @@ free_player_struct(Player *p)
 }
 
 //::map
+/*everything collision, drawing and level files need to know about a tile
+  type. the sheet only has the wall tile so far, the others reuse it*/
+const Tile_Props tile_props[NUM_MAP_SPRITES] = {
+    [NO_TILE]    = {.flags = 0, .friction = 1.0f, .glyph = '.',
+                    .sprite = {0, 0, 0, 0}, .tint = {1, 1, 1, 1}},
+    [WALL]       = {.flags = TF_SOLID | TF_AUTOTILE, .friction = 1.0f, .glyph = '#',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, .tint = {1, 1, 1, 1}},
+    [ONE_WAY]    = {.flags = TF_ONE_WAY, .friction = 1.0f, .glyph = '=',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, 4}, .tint = {1, 1, 1, 1}},
+    [SLOPE_UP]   = {.flags = TF_SLOPE, .slope_l = 0, .slope_r = TILE_SIZE, .friction = 1.0f, .glyph = '/',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, .tint = {1, 1, 1, 1}},
+    [SLOPE_DOWN] = {.flags = TF_SLOPE, .slope_l = TILE_SIZE, .slope_r = 0, .friction = 1.0f, .glyph = '\\',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, .tint = {1, 1, 1, 1}},
+    [SPIKES]     = {.flags = TF_SOLID | TF_HAZARD, .friction = 1.0f, .glyph = '^',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, .tint = {1, 0.35f, 0.35f, 1}},
+    [ICE]        = {.flags = TF_SOLID, .friction = 0.15f, .glyph = '~',
+                    .sprite = {0, 2 * TILE_SIZE, TILE_SIZE, TILE_SIZE}, .tint = {0.6f, 0.8f, 1, 1}},
+};
+
 Sprite*
 init_map_sprites(void)
 {
     Sprite* s_a = malloc(sizeof(Sprite) * NUM_MAP_SPRITES);
     if (s_a == NULL) return NULL;
 
-    s_a[NO_TILE] = load_map_sprite(NO_TILE);
-    s_a[WALL]    = load_map_sprite(WALL);
+    for (int i = 0; i < NUM_MAP_SPRITES; i++) {
+        s_a[i] = load_map_sprite(i);
+    }
 
     return s_a;
 }
@@ -716,67 +1036,577 @@ Sprite
 load_map_sprite(int id)
 {
     Sprite s = (Sprite) {
-        .source = (SDL_FRect) {.w = TILE_SIZE, .h = TILE_SIZE},
+        .source = tile_props[id].sprite,
     };
+    return s;
+}
 
-    switch (id) {
-        case NO_TILE:
-            break;
-        case WALL:
-            s.source.x = 0;
-            s.source.y = 2 * TILE_SIZE;
-            break;
-        default:
-            break;   
+int
+tile_from_glyph(char c)
+{
+    for (int i = 0; i < NUM_MAP_SPRITES; i++) {
+        if (tile_props[i].glyph == c) return i;
     }
-    return s;
+    return NO_TILE;
 }
 
 Map*
-gen_test_map(void)
+alloc_map(int rows, int cols)
 {
-    int rows, cols;
+    int r;
     Map* m = malloc(sizeof(Map));
     if (m == NULL) return NULL;
 
-    for (rows = 0; rows < MAP_ROWS; rows++) {
-        for (cols = 0; cols < MAP_COLS; cols++) {
-            m->tile_id[rows][cols] = 0;
-        }
+    m->rows           = rows;
+    m->cols           = cols;
+    m->edit_seq       = 0;
+    m->mask_words     = (cols + 63) / 64;
+    m->chunk_rows     = (rows + CHUNK_TILES - 1) / CHUNK_TILES;
+    m->chunk_cols     = (cols + CHUNK_TILES - 1) / CHUNK_TILES;
+    m->tile_id        = malloc(sizeof(int*) * rows);
+    m->neighbour_mask = malloc(sizeof(uint8_t*) * rows);
+    m->solid_mask     = calloc((size_t) rows * m->mask_words, sizeof(uint64_t));
+    m->chunk_cache    = calloc((size_t) m->chunk_rows * m->chunk_cols, sizeof(SDL_Texture*));
+    m->chunk_dirty    = malloc(sizeof(bool) * m->chunk_rows * m->chunk_cols);
+    m->chunk_atlas    = calloc((size_t) m->chunk_rows * m->chunk_cols, sizeof(int));
+    m->modified_chunks = malloc(sizeof(int) * m->chunk_rows * m->chunk_cols);
+    m->modified_slot   = malloc(sizeof(int) * m->chunk_rows * m->chunk_cols);
+    m->num_modified    = 0;
+    m->view_chunks    = (SDL_Rect) {0, 0, 0, 0};
+    m->num_atlases    = 0;
+    m->platforms      = NULL;
+    if (m->tile_id != NULL) {
+        m->tile_id[0] = calloc((size_t) rows * cols, sizeof(int));
+    }
+    if (m->neighbour_mask != NULL) {
+        m->neighbour_mask[0] = calloc((size_t) rows * cols, sizeof(uint8_t));
+    }
+
+    if (m->tile_id == NULL || m->tile_id[0] == NULL || m->solid_mask == NULL ||
+        m->neighbour_mask == NULL || m->neighbour_mask[0] == NULL ||
+        m->chunk_cache == NULL || m->chunk_dirty == NULL || m->chunk_atlas == NULL ||
+        m->modified_chunks == NULL || m->modified_slot == NULL) {
+        free_map(NULL, m);
+        return NULL;
+    }
+
+    for (r = 1; r < rows; r++) {
+        m->tile_id[r]        = m->tile_id[0] + r * cols;
+        m->neighbour_mask[r] = m->neighbour_mask[0] + r * cols;
+    }
+    for (r = 0; r < m->chunk_rows * m->chunk_cols; r++) {
+        m->modified_slot[r] = -1;
     }
 
+    map_build_masks(m);
+    map_invalidate_chunks(m);
+
+    return m;
+}
+
+Map*
+gen_test_map(void)
+{
+    int rows, cols;
+    Map* m = alloc_map(MAP_ROWS, MAP_COLS);
+    if (m == NULL) return NULL;
+
     rows = (MAP_ROWS / 2) + 1;
 
     for (cols = 0; cols < MAP_COLS; cols++) {
-        m->tile_id[rows][cols] = WALL;
+        map_set_tile(m, rows, cols, WALL);
     }
 
-    m->tile_id[7][7] = WALL;
-    m->tile_id[6][6] = WALL;
-    m->tile_id[5][5] = WALL;
-    m->tile_id[5][7] = WALL;
+    map_set_tile(m, 7, 7, WALL);
+    map_set_tile(m, 6, 6, WALL);
+    map_set_tile(m, 5, 5, WALL);
+    map_set_tile(m, 5, 7, WALL);
 
     return m;
 }
 
+Map*
+map_load(const char *filepath)
+{
+    int rows, cols;
+    char c;
+
+    FILE *f = fopen(filepath, "r");
+    if (f == NULL) return NULL;
+
+    if (fscanf(f, "%d %d", &rows, &cols) != 2 || rows <= 0 || cols <= 0) {
+        printf("Level %s has no size line\n", filepath);
+        fclose(f);
+        return NULL;
+    }
+
+    Map *m = alloc_map(rows, cols);
+    if (m == NULL) {
+        fclose(f);
+        return NULL;
+    }
+
+    /*one character per tile, glyphs come from tile_props and anything
+      unknown is empty*/
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            if (fscanf(f, " %c", &c) != 1) {
+                printf("Level %s ends early at row %d\n", filepath, row);
+                fclose(f);
+                free_map(NULL, m);
+                return NULL;
+            }
+            map_set_tile(m, row, col, tile_from_glyph(c));
+        }
+    }
+
+    /*optional lines after the grid put a chunk on another atlas*/
+    Level_Atlas la;
+    while (m->num_atlases < MAX_LEVEL_ATLASES &&
+           fscanf(f, " atlas %d %d %127s", &la.c_row, &la.c_col, la.path) == 3) {
+        if (la.c_row < 0 || la.c_row >= m->chunk_rows || la.c_col < 0 || la.c_col >= m->chunk_cols) {
+            printf("Level %s puts an atlas on chunk %d,%d, outside the map\n", filepath, la.c_row, la.c_col);
+            continue;
+        }
+        m->atlases[m->num_atlases++] = la;
+    }
+
+    fclose(f);
+    return m;
+}
+
+bool
+map_save(Map *m, const char *filepath)
+{
+    char tmp[256];
+
+    /*the level file is the only copy, so it's written beside it and renamed
+      over it once complete. the watcher sees the rename as one change*/
+    SDL_snprintf(tmp, sizeof(tmp), "%s.tmp", filepath);
+    FILE *f = fopen(tmp, "w");
+    if (f == NULL) {
+        printf("Couldn't save level to %s\n", filepath);
+        return false;
+    }
+
+    fprintf(f, "%d %d\n", m->rows, m->cols);
+    for (int row = 0; row < m->rows; row++) {
+        for (int col = 0; col < m->cols; col++) {
+            fputc(tile_props[m->tile_id[row][col]].glyph, f);
+        }
+        fputc('\n', f);
+    }
+    for (int i = 0; i < m->num_atlases; i++) {
+        fprintf(f, "atlas %d %d %s\n", m->atlases[i].c_row, m->atlases[i].c_col, m->atlases[i].path);
+    }
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok && SDL_RenamePath(tmp, filepath);
+    if (!ok) {
+        SDL_RemovePath(tmp);
+        printf("Couldn't save level to %s, the old one is untouched\n", filepath);
+        return false;
+    }
+
+    printf("saved %dx%d level to %s\n", m->rows, m->cols, filepath);
+    return true;
+}
+
+void
+map_set_tile(Map *m, int row, int col, int id)
+{
+    if (row < 0 || row >= m->rows || col < 0 || col >= m->cols) return;
+
+    uint64_t *word = &m->solid_mask[row * m->mask_words + col / 64];
+    uint64_t bit   = (uint64_t) 1 << (col % 64);
+
+    if (m->tile_id[row][col] == id) return;
+
+    m->edit_log[m->edit_seq % MAP_EDIT_LOG] = (SDL_Point) {.x = col, .y = row};
+    m->edit_seq++;
+
+    m->tile_id[row][col] = id;
+    map_mark_modified(m, (row / CHUNK_TILES) * m->chunk_cols + col / CHUNK_TILES);
+    if (tile_props[id].flags & TF_SOLID) {
+        *word |= bit;
+    } else {
+        *word &= ~bit;
+    }
+
+    /*the tile's own variant and its neighbours' masks are all that change*/
+    for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+            if (r < 0 || r >= m->rows || c < 0 || c >= m->cols) continue;
+            map_update_mask(m, r, c);
+            map_mark_chunk_dirty(m, r, c);
+        }
+    }
+}
+
+void
+map_build_masks(Map *m)
+{
+    int row, col;
+    for (row = 0; row < m->rows; row++) {
+        for (col = 0; col < m->cols; col++) {
+            map_update_mask(m, row, col);
+        }
+    }
+}
+
+void
+map_update_mask(Map *m, int row, int col)
+{
+    /*bit order N, NE, E, SE, S, SW, W, NW. off-map counts as wall so
+      walls on the map border read as continuing past it*/
+    static const int d_row[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    static const int d_col[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    uint8_t mask = 0;
+
+    for (int i = 0; i < 8; i++) {
+        int r = row + d_row[i], c = col + d_col[i];
+        if (r < 0 || r >= m->rows || c < 0 || c >= m->cols || tile_is_solid(m, r, c)) {
+            mask |= 1 << i;
+        }
+    }
+    m->neighbour_mask[row][col] = mask;
+}
+
+int
+autotile_variant(uint8_t mask)
+{
+    /*blob tileset: a corner only matters when both sides next to it are
+      set, which leaves 47 distinct variants*/
+    static const uint8_t blob[256] = {
+         0,  1,  0,  1,  2,  3,  2,  4,  0,  1,  0,  1,  2,  3,  2,  4,
+         5,  6,  5,  6,  7,  8,  7,  9,  5,  6,  5,  6, 10, 11, 10, 12,
+         0,  1,  0,  1,  2,  3,  2,  4,  0,  1,  0,  1,  2,  3,  2,  4,
+         5,  6,  5,  6,  7,  8,  7,  9,  5,  6,  5,  6, 10, 11, 10, 12,
+        13, 14, 13, 14, 15, 16, 15, 17, 13, 14, 13, 14, 15, 16, 15, 17,
+        18, 19, 18, 19, 20, 21, 20, 22, 18, 19, 18, 19, 23, 24, 23, 25,
+        13, 14, 13, 14, 15, 16, 15, 17, 13, 14, 13, 14, 15, 16, 15, 17,
+        26, 27, 26, 27, 28, 29, 28, 30, 26, 27, 26, 27, 31, 32, 31, 33,
+         0,  1,  0,  1,  2,  3,  2,  4,  0,  1,  0,  1,  2,  3,  2,  4,
+         5,  6,  5,  6,  7,  8,  7,  9,  5,  6,  5,  6, 10, 11, 10, 12,
+         0,  1,  0,  1,  2,  3,  2,  4,  0,  1,  0,  1,  2,  3,  2,  4,
+         5,  6,  5,  6,  7,  8,  7,  9,  5,  6,  5,  6, 10, 11, 10, 12,
+        13, 34, 13, 34, 15, 35, 15, 36, 13, 34, 13, 34, 15, 35, 15, 36,
+        18, 37, 18, 37, 20, 38, 20, 39, 18, 37, 18, 37, 23, 40, 23, 41,
+        13, 34, 13, 34, 15, 35, 15, 36, 13, 34, 13, 34, 15, 35, 15, 36,
+        26, 42, 26, 42, 28, 43, 28, 44, 26, 42, 26, 42, 31, 45, 31, 46,
+    };
+    return blob[mask];
+}
+
+SDL_FRect
+autotile_source(Sprite *m_s, int id, uint8_t mask)
+{
+    SDL_FRect src = m_s[id].source;
+    if (!(tile_props[id].flags & TF_AUTOTILE)) return src;
+
+    /*variants run along the wall row of the sheet, 16 to a row*/
+    int v = autotile_variant(mask);
+    if (v >= WALL_VARIANTS) return src;
+
+    src.x += (v % 16) * TILE_SIZE;
+    src.y += (v / 16) * TILE_SIZE;
+    return src;
+}
+
+void
+map_mark_chunk_dirty(Map *m, int row, int col)
+{
+    m->chunk_dirty[(row / CHUNK_TILES) * m->chunk_cols + col / CHUNK_TILES] = true;
+}
+
+void
+map_mark_modified(Map *m, int chunk)
+{
+    if (m->modified_slot[chunk] >= 0) return;
+
+    m->modified_slot[chunk] = m->num_modified;
+    m->modified_chunks[m->num_modified++] = chunk;
+}
+
+void
+map_clear_modified(Map *m, int chunk)
+{
+    int slot = m->modified_slot[chunk];
+    if (slot < 0) return;
+
+    /*swap the last entry into the hole*/
+    int last = m->modified_chunks[--m->num_modified];
+    m->modified_chunks[slot] = last;
+    m->modified_slot[last]   = slot;
+    m->modified_slot[chunk]  = -1;
+}
+
+void
+map_invalidate_chunks(Map *m)
+{
+    for (int i = 0; i < m->chunk_rows * m->chunk_cols; i++) {
+        m->chunk_dirty[i] = true;
+    }
+}
+
+void
+map_mark_atlas_dirty(Map *m, int atlas)
+{
+    for (int i = 0; i < m->chunk_rows * m->chunk_cols; i++) {
+        if (m->chunk_atlas[i] == atlas) m->chunk_dirty[i] = true;
+    }
+}
+
+int
+map_reload(Map *m, const char *filepath)
+{
+    int changed = 0;
+
+    Map *fresh = map_load(filepath);
+    if (fresh == NULL) return -1;
+
+    if (fresh->rows != m->rows || fresh->cols != m->cols) {
+        printf("Level %s is now %dx%d, restart to load it\n", filepath, fresh->rows, fresh->cols);
+        free_map(NULL, fresh);
+        return -1;
+    }
+
+    /*only tiles that differ go through map_set_tile, so just their chunks
+      re-bake and everything keyed off edit_seq catches up incrementally*/
+    for (int row = 0; row < m->rows; row++) {
+        for (int col = 0; col < m->cols; col++) {
+            if (m->tile_id[row][col] == fresh->tile_id[row][col]) continue;
+            map_set_tile(m, row, col, fresh->tile_id[row][col]);
+            changed++;
+        }
+    }
+
+    /*the atlas lines come along, bind_level_atlases applies them*/
+    SDL_memcpy(m->atlases, fresh->atlases, sizeof(m->atlases));
+    m->num_atlases = fresh->num_atlases;
+
+    free_map(NULL, fresh);
+    return changed;
+}
+
+bool
+tile_is_solid(Map *m, int row, int col)
+{
+    if (row < 0 || row >= m->rows || col < 0 || col >= m->cols) return false;
+    return (m->solid_mask[row * m->mask_words + col / 64] >> (col % 64)) & 1;
+}
+
+bool
+map_area_has_solid(Map *m, int top, int left, int bot, int right)
+{
+    /*inclusive tile bounds, tested a 64-bit word of the row mask at a time*/
+    int row, w;
+
+    top   = top   < 0 ? 0 : top;
+    left  = left  < 0 ? 0 : left;
+    bot   = bot   >= m->rows ? m->rows - 1 : bot;
+    right = right >= m->cols ? m->cols - 1 : right;
+    if (top > bot || left > right) return false;
+
+    int first_w = left / 64, last_w = right / 64;
+    uint64_t first_bits = ~(uint64_t) 0 << (left % 64);
+    uint64_t last_bits  = ~(uint64_t) 0 >> (63 - right % 64);
+
+    for (row = top; row <= bot; row++) {
+        uint64_t *mask = &m->solid_mask[row * m->mask_words];
+        for (w = first_w; w <= last_w; w++) {
+            uint64_t bits = mask[w];
+            if (w == first_w) bits &= first_bits;
+            if (w == last_w)  bits &= last_bits;
+            if (bits) return true;
+        }
+    }
+
+    return false;
+}
+
+void
+map_set_chunk_atlas(Map *m, int c_row, int c_col, int atlas)
+{
+    int idx = c_row * m->chunk_cols + c_col;
+    if (m->chunk_atlas[idx] == atlas) return;
+
+    m->chunk_atlas[idx] = atlas;
+    m->chunk_dirty[idx] = true;
+}
+
+void
+bind_level_atlases(Texture_Manager *tm, Map *m, int sheet)
+{
+    int handle[MAX_LEVEL_ATLASES];
+
+    /*each path is decoded once however many chunks use it, one that won't
+      load leaves its chunks on the sheet*/
+    for (int i = 0; i < m->num_atlases; i++) {
+        handle[i] = find_texture(tm, m->atlases[i].path);
+        if (handle[i] < 0) handle[i] = register_texture(tm, m->atlases[i].path);
+        if (handle[i] < 0) {
+            printf("Couldn't load atlas %s, chunk %d,%d stays on the sheet\n",
+                m->atlases[i].path, m->atlases[i].c_row, m->atlases[i].c_col);
+            handle[i] = sheet;
+        }
+    }
+
+    /*only chunks whose atlas actually changes re-bake*/
+    for (int c_row = 0; c_row < m->chunk_rows; c_row++) {
+        for (int c_col = 0; c_col < m->chunk_cols; c_col++) {
+            int atlas = sheet;
+            for (int i = 0; i < m->num_atlases; i++) {
+                if (m->atlases[i].c_row == c_row && m->atlases[i].c_col == c_col) atlas = handle[i];
+            }
+            map_set_chunk_atlas(m, c_row, c_col, atlas);
+        }
+    }
+}
+
+SDL_Rect
+map_visible_chunks(Game* g, Map* m)
+{
+    int side = CHUNK_TILES * TILE_SIZE;
+    int left = (int) g->camera.x / side, top = (int) g->camera.y / side;
+    int right = ((int) g->camera.x + G_WIDTH - 1) / side;
+    int bot   = ((int) g->camera.y + G_HEIGHT - 1) / side;
+
+    right = SDL_min(right, m->chunk_cols - 1);
+    bot   = SDL_min(bot, m->chunk_rows - 1);
+
+    return (SDL_Rect) {left, top, right - left + 1, bot - top + 1};
+}
+
+void
+release_hidden_chunks(Map* m, SDL_Rect view)
+{
+    /*keep a one chunk ring around the view baked, drop the rest*/
+    for (int c_row = 0; c_row < m->chunk_rows; c_row++) {
+        for (int c_col = 0; c_col < m->chunk_cols; c_col++) {
+            int idx = c_row * m->chunk_cols + c_col;
+            if (m->chunk_cache[idx] == NULL) continue;
+            if (c_col >= view.x - 1 && c_col <= view.x + view.w &&
+                c_row >= view.y - 1 && c_row <= view.y + view.h) {
+                continue;
+            }
+            SDL_DestroyTexture(m->chunk_cache[idx]);
+            m->chunk_cache[idx] = NULL;
+        }
+    }
+}
+
 void
 draw_map(Game* g, Sprite* m_s, Map* m)
 {
-    SDL_FRect dest = (SDL_FRect) {.w = 16.0, .h = 16.0};
+    SDL_FRect dest = (SDL_FRect) {.w = CHUNK_TILES * TILE_SIZE, .h = CHUNK_TILES * TILE_SIZE};
+    SDL_Rect view = map_visible_chunks(g, m);
+    int c_row, c_col;
+
+    if (view.x != m->view_chunks.x || view.y != m->view_chunks.y ||
+        view.w != m->view_chunks.w || view.h != m->view_chunks.h) {
+        release_hidden_chunks(m, view);
+        m->view_chunks = view;
+    }
+
+    for (c_row = view.y; c_row < view.y + view.h; c_row++) {
+        for (c_col = view.x; c_col < view.x + view.w; c_col++) {
+            int idx = c_row * m->chunk_cols + c_col;
+            if (m->chunk_dirty[idx] || m->chunk_cache[idx] == NULL) {
+                draw_chunk(g, m_s, m, c_row, c_col);
+            }
+            if (m->chunk_cache[idx] == NULL) continue;
+
+            dest.x = c_col * CHUNK_TILES * TILE_SIZE - g->camera.x;
+            dest.y = c_row * CHUNK_TILES * TILE_SIZE - g->camera.y;
+            SDL_RenderTexture(g->renderer, m->chunk_cache[idx], NULL, &dest);
+            g->draw_calls++;
+        }
+    }
+}
+
+void
+draw_chunk(Game* g, Sprite* m_s, Map* m, int c_row, int c_col)
+{
+    int idx  = c_row * m->chunk_cols + c_col;
+    int side = CHUNK_TILES * TILE_SIZE;
     int rows, cols;
-    for (rows = 0; rows < MAP_ROWS; rows++) {
-        for (cols = 0; cols < MAP_COLS; cols++) {
+
+    /*only chunks coming into view ask for their atlas, which is what makes
+      the texture manager upload on demand*/
+    SDL_Texture *atlas = g->textures != NULL ?
+        get_texture(g->textures, m->chunk_atlas[idx]) : g->spritesheet;
+    if (atlas == NULL) return;
+
+    if (m->chunk_cache[idx] == NULL) {
+        m->chunk_cache[idx] = SDL_CreateTexture(g->renderer,
+            SDL_PIXELFORMAT_RGBA8888,
+            SDL_TEXTUREACCESS_TARGET,
+            side,
+            side);
+        if (m->chunk_cache[idx] == NULL) return;
+        SDL_SetTextureBlendMode(m->chunk_cache[idx], SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(m->chunk_cache[idx], SDL_SCALEMODE_NEAREST);
+    }
+
+    SDL_Texture *prev = SDL_GetRenderTarget(g->renderer);
+    SDL_SetRenderTarget(g->renderer, m->chunk_cache[idx]);
+    SDL_SetRenderDrawColor(g->renderer, 0, 0, 0, 0);
+    SDL_RenderClear(g->renderer);
+
+    int top  = c_row * CHUNK_TILES, left = c_col * CHUNK_TILES;
+    int bot  = SDL_min(top + CHUNK_TILES, m->rows);
+    int right = SDL_min(left + CHUNK_TILES, m->cols);
+    for (rows = top; rows < bot; rows++) {
+        for (cols = left; cols < right; cols++) {
             if (m->tile_id[rows][cols] != NO_TILE) {
-                Sprite to_draw = m_s[m->tile_id[rows][cols]];
-                dest.x = cols * TILE_SIZE;
-                dest.y = rows * TILE_SIZE;
-                SDL_RenderTexture(g->renderer,
-                    g->spritesheet,
-                    &to_draw.source,
-                    &dest);
+                SDL_FRect src = autotile_source(m_s,
+                    m->tile_id[rows][cols],
+                    m->neighbour_mask[rows][cols]);
+                draw_tile(g, atlas, m->tile_id[rows][cols], src,
+                    (cols - left) * TILE_SIZE, (rows - top) * TILE_SIZE);
             }
         }
     }
+    SDL_SetTextureColorMod(atlas, 255, 255, 255);
+
+    SDL_SetRenderTarget(g->renderer, prev);
+    m->chunk_dirty[idx] = false;
+}
+
+void
+draw_tile(Game* g, SDL_Texture *atlas, int id, SDL_FRect src, float x, float y)
+{
+    const Tile_Props *tp = &tile_props[id];
+
+    if (!(tp->flags & TF_SLOPE)) {
+        SDL_FRect dest = (SDL_FRect) {x, y, src.w, src.h};
+        SDL_SetTextureColorMod(atlas,
+            (Uint8) (tp->tint.r * 255), (Uint8) (tp->tint.g * 255), (Uint8) (tp->tint.b * 255));
+        SDL_RenderTexture(g->renderer, atlas, &src, &dest);
+        g->draw_calls++;
+        return;
+    }
+
+    /*slopes are cut along their height profile so the art matches the
+      surface the collision uses*/
+    float tex_w, tex_h;
+    if (!SDL_GetTextureSize(atlas, &tex_w, &tex_h)) return;
+
+    float top_l = TILE_SIZE - tp->slope_l, top_r = TILE_SIZE - tp->slope_r;
+    float u0 = src.x / tex_w, u1 = (src.x + src.w) / tex_w;
+    float v1 = (src.y + src.h) / tex_h;
+    SDL_Vertex v[4] = {
+        {{x, y + top_l}, tp->tint, {u0, (src.y + top_l) / tex_h}},
+        {{x + TILE_SIZE, y + top_r}, tp->tint, {u1, (src.y + top_r) / tex_h}},
+        {{x + TILE_SIZE, y + TILE_SIZE}, tp->tint, {u1, v1}},
+        {{x, y + TILE_SIZE}, tp->tint, {u0, v1}},
+    };
+    static const int idx[6] = {0, 1, 2, 0, 2, 3};
+
+    SDL_SetTextureColorMod(atlas, 255, 255, 255);
+    SDL_RenderGeometry(g->renderer, atlas, v, 4, idx, 6);
+    g->draw_calls++;
 }
 
 int
@@ -806,21 +1636,80 @@ rect_right(SDL_FRect r)
 Collision_Info
 get_wall_collision_coords(Map *m, SDL_FRect r)
 {
-    Collision_Info info = (Collision_Info) {false, 0, 0};
+    /*no motion, so only fully solid tiles count*/
+    return get_tile_collision(m, r, 0);
+}
+
+Collision_Info
+get_tile_collision(Map *m, SDL_FRect r, int dy)
+{
+    Collision_Info info = (Collision_Info) {.collided = false, .platform = -1, .tile = -1};
 
     if (!m) return info;
 
     Colliding_Tiles c = {0};
     get_colliding_tiles(&c, r);
 
+    /*one-way tops and slopes only stop bodies coming down onto them. dy is
+      how far the body moved, so its feet before the move are known*/
+    uint8_t want = TF_SOLID | (dy > 0 ? TF_ONE_WAY | TF_SLOPE : 0);
+    int feet = rect_bot(r), prev_feet = feet - dy;
+    int mid  = (int) (r.x + r.w / 2);
+
     int i, x, y;
     for (i = 0; i < c.index; i++) {
         y = c.col_tiles[i].y;
         x = c.col_tiles[i].x;
-        if (m->tile_id[y][x] == WALL) {
-            info = (Collision_Info) {true, y, x};
-            return info;
+        if (y < 0 || y >= m->rows || x < 0 || x >= m->cols) continue;
+
+        const Tile_Props *tp = &tile_props[m->tile_id[y][x]];
+        uint8_t hit = tp->flags & want;
+        if (!hit) continue;
+
+        SDL_FRect box = (SDL_FRect) {x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+        if (hit == TF_SLOPE) {
+            /*the surface under the body's middle is what it stands on*/
+            if (mid < x * TILE_SIZE || mid >= (x + 1) * TILE_SIZE) continue;
+            float t = (mid - x * TILE_SIZE + 0.5f) / TILE_SIZE;
+            float h = roundf(tp->slope_l + (tp->slope_r - tp->slope_l) * t);
+            box.y = (y + 1) * TILE_SIZE - h;
+            box.h = h;
+            if (feet < box.y) continue;
+        } else if (hit == TF_ONE_WAY && prev_feet > box.y) {
+            continue;
         }
+
+        info = (Collision_Info) {
+            .collided = true,
+            .row      = y,
+            .col      = x,
+            .rect     = box,
+            .platform = -1,
+            .tile     = m->tile_id[y][x],
+        };
+        return info;
+    }
+
+    return info;
+}
+
+Collision_Info
+get_solid_collision(Map *m, SDL_FRect r, int dx, int dy)
+{
+    Collision_Info info = get_tile_collision(m, r, dy);
+
+    if (m == NULL || m->platforms == NULL) return info;
+
+    Collision_Info plat = collide_platforms(m->platforms, r, dx, dy);
+    if (!plat.collided) return info;
+    if (!info.collided) return plat;
+
+    /*both in the way, the one met first along the motion wins*/
+    if ((dy > 0 && plat.rect.y < info.rect.y) ||
+        (dy < 0 && plat.rect.y + plat.rect.h > info.rect.y + info.rect.h) ||
+        (dx > 0 && plat.rect.x < info.rect.x) ||
+        (dx < 0 && plat.rect.x + plat.rect.w > info.rect.x + info.rect.w)) {
+        return plat;
     }
 
     return info;
@@ -856,6 +1745,22 @@ free_map(Sprite* s_a, Map* m)
     }
     if (m != NULL) {
         printf("...freeing Map\n");
+        if (m->tile_id != NULL) free(m->tile_id[0]);
+        if (m->neighbour_mask != NULL) free(m->neighbour_mask[0]);
+        if (m->chunk_cache != NULL) {
+            for (int i = 0; i < m->chunk_rows * m->chunk_cols; i++) {
+                if (m->chunk_cache[i] != NULL) SDL_DestroyTexture(m->chunk_cache[i]);
+            }
+        }
+        free(m->tile_id);
+        free(m->neighbour_mask);
+        free(m->solid_mask);
+        free(m->chunk_cache);
+        free(m->chunk_dirty);
+        free(m->chunk_atlas);
+        free(m->modified_chunks);
+        free(m->modified_slot);
+        free_platforms(m->platforms);
         free(m);
     }
 }
@@ -0,0 +1,466 @@
+#include "caves.h"
+
+//::nav
+Nav*
+nav_build(Map *m, Physics *ph)
+{
+    Nav *n;
+    int tiles = m->rows * m->cols;
+
+    n = malloc(sizeof(Nav));
+    if (n == NULL) return NULL;
+
+    /*speeds are px/ms and gravities px/ms^2. holding jump uses jump_gravity
+      on the way up, so the rise is v^2 / 2g and the apex comes at v / g*/
+    float rise_px  = ph->jump_speed * ph->jump_speed / (2.0f * ph->jump_gravity);
+    float apex_ms  = ph->jump_speed / ph->jump_gravity;
+
+    n->rows             = m->rows;
+    n->cols             = m->cols;
+    n->jump_tiles       = (int) (rise_px / TILE_SIZE);
+    n->reach_tiles      = (int) (ph->max_speed_x * apex_ms / TILE_SIZE);
+    n->walk_cost        = (int) (TILE_SIZE / ph->max_speed_x);
+    n->jump_cost        = (int) apex_ms;
+    n->fall_ms_per_tile = sqrtf(2.0f * TILE_SIZE / ph->gravity);
+    n->standable        = calloc(tiles, sizeof(uint8_t));
+    n->num_edges        = calloc(tiles, sizeof(uint8_t));
+    n->edges            = malloc(sizeof(Nav_Edge) * tiles * NAV_MAX_EDGES);
+    n->in_head          = malloc(sizeof(int) * tiles);
+    n->in_next          = malloc(sizeof(int) * tiles * NAV_MAX_EDGES);
+    n->in_prev          = malloc(sizeof(int) * tiles * NAV_MAX_EDGES);
+    n->dist             = malloc(sizeof(int) * tiles);
+    n->next             = malloc(sizeof(Nav_Edge) * tiles);
+    n->work_dist        = malloc(sizeof(int) * tiles);
+    n->work_rhs         = malloc(sizeof(int) * tiles);
+    n->work_next        = malloc(sizeof(int) * tiles);
+    n->changed          = calloc(tiles, sizeof(uint8_t));
+    n->changed_list     = malloc(sizeof(int) * tiles);
+    n->num_changed      = 0;
+    n->heap_cap         = 0;
+    n->heap             = NULL;
+    n->heap_len         = 0;
+    n->goal             = -1;
+    n->work_goal        = -1;
+    n->pending_goal     = -1;
+    n->building         = false;
+    n->stalled          = false;
+    n->map_seq          = m->edit_seq;
+    n->publishes        = 0;
+    n->pops             = 0;
+
+    if (!n->standable || !n->num_edges || !n->edges || !n->in_head || !n->in_next ||
+        !n->in_prev || !n->dist || !n->next || !n->work_dist || !n->work_rhs ||
+        !n->work_next || !n->changed || !n->changed_list) {
+        free_nav(n);
+        return NULL;
+    }
+
+    for (int i = 0; i < tiles; i++) {
+        n->in_head[i]   = -1;
+        n->dist[i]      = INT32_MAX;
+        n->next[i]      = (Nav_Edge) {.to = -1, .action = NAV_NONE, .cost = 0};
+        n->work_dist[i] = INT32_MAX;
+        n->work_rhs[i]  = INT32_MAX;
+        n->work_next[i] = -1;
+    }
+
+    nav_rebuild_columns(n, m, 0, m->cols - 1);
+
+    return n;
+}
+
+void
+nav_rebuild_columns(Nav *n, Map *m, int left, int right)
+{
+    int row, col;
+
+    left  = left  < 0 ? 0 : left;
+    right = right >= n->cols ? n->cols - 1 : right;
+
+    for (col = left; col <= right; col++) {
+        for (row = 0; row < n->rows; row++) {
+            n->standable[row * n->cols + col] = nav_is_standable(m, row, col);
+        }
+    }
+
+    /*edges of a node read standability up to reach_tiles + 1 columns away*/
+    int e_left  = left  - n->reach_tiles - 1;
+    int e_right = right + n->reach_tiles + 1;
+    e_left  = e_left  < 0 ? 0 : e_left;
+    e_right = e_right >= n->cols ? n->cols - 1 : e_right;
+
+    for (col = e_left; col <= e_right; col++) {
+        for (row = 0; row < n->rows; row++) {
+            nav_build_node_edges(n, m, row, col);
+        }
+    }
+
+    /*only out-edges changed, so only these nodes' rhs can be stale. the
+      repair spreads from them to whatever actually routes through here*/
+    for (col = e_left; col <= e_right; col++) {
+        for (row = 0; row < n->rows; row++) {
+            nav_update_node(n, row * n->cols + col);
+        }
+    }
+}
+
+void
+nav_sync_map(Nav *n, Map *m)
+{
+    uint32_t pending = m->edit_seq - n->map_seq;
+
+    if (pending == 0) return;
+
+    if (pending > MAP_EDIT_LOG) {
+        nav_rebuild_columns(n, m, 0, n->cols - 1);
+    } else {
+        for (; n->map_seq != m->edit_seq; n->map_seq++) {
+            SDL_Point e = m->edit_log[n->map_seq % MAP_EDIT_LOG];
+            nav_rebuild_columns(n, m, e.x, e.x);
+        }
+    }
+    n->map_seq = m->edit_seq;
+}
+
+void
+nav_set_goal(Nav *n, SDL_FPoint pos)
+{
+    int row = (int) floorf((pos.y + TILE_SIZE / 2) / TILE_SIZE);
+    int col = (int) floorf((pos.x + TILE_SIZE / 2) / TILE_SIZE);
+
+    /*mid-air the goal stays where the target last stood*/
+    if (row < 0 || row >= n->rows || col < 0 || col >= n->cols) return;
+    int node = row * n->cols + col;
+    if (!n->standable[node]) return;
+
+    /*a goal move can touch every node, so one that lands mid-repair would
+      restart the wait for a publish. it waits for the field in flight*/
+    if (n->building) {
+        n->pending_goal = node;
+        return;
+    }
+    nav_move_goal(n, node);
+}
+
+void
+nav_move_goal(Nav *n, int node)
+{
+    if (node == n->work_goal) return;
+
+    /*moving the goal is an rhs change at the old and new goal nodes,
+      everything else is repaired from there like any other edit*/
+    int old = n->work_goal;
+    n->work_goal       = node;
+    n->work_rhs[node]  = 0;
+    n->work_next[node] = -1;
+    nav_mark_changed(n, node);
+    if (n->work_dist[node] != 0) nav_heap_push(n, 0, node);
+    if (old >= 0) nav_update_node(n, old);
+}
+
+void
+nav_update(Nav *n, Map *m, SDL_FPoint goal_pos, int budget)
+{
+    nav_sync_map(n, m);
+    nav_set_goal(n, goal_pos);
+
+    if (n->stalled) return;
+
+    /*lpa* backwards from the goal over in-edges, a budget of pops per tick.
+      agents keep steering by the published field until this settles*/
+    while (n->heap_len > 0 && budget-- > 0) {
+        Nav_Heap_Item it = nav_heap_pop(n);
+        int u   = it.node;
+        int g   = n->work_dist[u];
+        int rhs = n->work_rhs[u];
+
+        /*lazy deletion: settled since, or pushed again with another key*/
+        if (g == rhs || it.d != SDL_min(g, rhs)) continue;
+        n->pops++;
+
+        if (g > rhs) {
+            n->work_dist[u] = rhs;
+        } else {
+            /*got worse: forget it and let it pick its best way out again*/
+            n->work_dist[u] = INT32_MAX;
+            nav_update_node(n, u);
+        }
+        nav_mark_changed(n, u);
+
+        for (int slot = n->in_head[u]; slot >= 0; slot = n->in_next[slot]) {
+            nav_update_node(n, slot / NAV_MAX_EDGES);
+        }
+        if (n->stalled) return;
+    }
+
+    n->building = n->heap_len > 0;
+    if (n->building) return;
+
+    nav_publish(n);
+    if (n->pending_goal >= 0) {
+        nav_move_goal(n, n->pending_goal);
+        n->pending_goal = -1;
+    }
+    n->building = n->heap_len > 0;
+}
+
+Nav_Step
+nav_query(Nav *n, SDL_FPoint pos)
+{
+    Nav_Step s = (Nav_Step) {.action = NAV_NONE, .cost = INT32_MAX};
+
+    int row = (int) floorf((pos.y + TILE_SIZE / 2) / TILE_SIZE);
+    int col = (int) floorf((pos.x + TILE_SIZE / 2) / TILE_SIZE);
+    if (row < 0 || row >= n->rows || col < 0 || col >= n->cols) return s;
+
+    int node = row * n->cols + col;
+    s.cost = n->dist[node];
+    if (n->next[node].to < 0) return s;
+
+    s.action = n->next[node].action;
+    s.target = (SDL_Point) {.x = n->next[node].to % n->cols, .y = n->next[node].to / n->cols};
+
+    return s;
+}
+
+void
+print_nav_stats(Nav *n)
+{
+    if (n == NULL || n->publishes == 0) return;
+
+    printf("nav: %llu fields published, %llu repair pops, %.1f pops per field\n",
+        (unsigned long long) n->publishes,
+        (unsigned long long) n->pops,
+        (double) n->pops / n->publishes);
+}
+
+void
+free_nav(Nav *n)
+{
+    if (n != NULL) {
+        printf("...freeing Nav\n");
+        print_nav_stats(n);
+        free(n->standable);
+        free(n->num_edges);
+        free(n->edges);
+        free(n->in_head);
+        free(n->in_next);
+        free(n->in_prev);
+        free(n->dist);
+        free(n->next);
+        free(n->work_dist);
+        free(n->work_rhs);
+        free(n->work_next);
+        free(n->changed);
+        free(n->changed_list);
+        free(n->heap);
+        free(n);
+    }
+}
+
+bool
+nav_is_standable(Map *m, int row, int col)
+{
+    /*the player body is one tile, so a node needs an open tile over a solid one*/
+    return !tile_is_solid(m, row, col) && row + 1 < m->rows && tile_is_solid(m, row + 1, col);
+}
+
+void
+nav_build_node_edges(Nav *n, Map *m, int row, int col)
+{
+    int node = row * n->cols + col;
+    int dir, dx, dy, r;
+
+    for (int e = 0; e < n->num_edges[node]; e++) {
+        nav_unlink_edge(n, node * NAV_MAX_EDGES + e);
+    }
+    n->num_edges[node] = 0;
+    /*slots get reused in a new order, so the published copy needs a refresh*/
+    nav_mark_changed(n, node);
+    if (!n->standable[node]) return;
+
+    for (dir = -1; dir <= 1; dir += 2) {
+        int c = col + dir;
+        if (c < 0 || c >= n->cols || tile_is_solid(m, row, c)) continue;
+
+        if (n->standable[row * n->cols + c]) {
+            nav_add_edge(n, node, row * n->cols + c, NAV_WALK, n->walk_cost);
+            continue;
+        }
+
+        /*off a ledge, drop straight down the next column*/
+        for (r = row + 1; r < n->rows && !tile_is_solid(m, r, c); r++) {
+            if (n->standable[r * n->cols + c]) {
+                nav_add_edge(n, node, r * n->cols + c, NAV_FALL,
+                    n->walk_cost + (int) (n->fall_ms_per_tile * sqrtf(r - row)));
+                break;
+            }
+        }
+    }
+
+    /*jumps, nearest first so a full edge list drops the longest ones.
+      clearance is checked as rise to the apex row, then across*/
+    for (dx = 0; dx <= n->reach_tiles; dx++) {
+        for (dy = 0; dy <= n->jump_tiles; dy++) {
+            for (dir = -1; dir <= 1; dir += 2) {
+                int c = col + dir * dx, r_to = row - dy;
+                int apex = row - (dy > 0 ? dy : 1);
+                if (dx == 0 && dir > 0) continue;
+                if (dy == 0 && dx <= 1) continue;
+                if (c < 0 || c >= n->cols || r_to < 0 || apex < 0) continue;
+                if (!n->standable[r_to * n->cols + c]) continue;
+                /*same height with solid footing between: walking is cheaper*/
+                if (dy == 0 && n->standable[row * n->cols + col + dir]) continue;
+
+                int left = dir > 0 ? col : c, right = dir > 0 ? c : col;
+                if (map_area_has_solid(m, apex, col, row - 1, col) ||
+                    map_area_has_solid(m, apex, left, apex, right) ||
+                    map_area_has_solid(m, apex, c, r_to, c)) {
+                    continue;
+                }
+
+                nav_add_edge(n, node, r_to * n->cols + c, NAV_JUMP,
+                    n->jump_cost + dx * n->walk_cost);
+            }
+        }
+    }
+}
+
+void
+nav_add_edge(Nav *n, int from, int to, Nav_Action action, int cost)
+{
+    if (n->num_edges[from] >= NAV_MAX_EDGES) return;
+
+    int slot = from * NAV_MAX_EDGES + n->num_edges[from];
+    n->edges[slot] = (Nav_Edge) {
+        .to     = to,
+        .action = action,
+        .cost   = cost,
+    };
+    n->num_edges[from]++;
+    nav_link_edge(n, slot);
+}
+
+void
+nav_link_edge(Nav *n, int slot)
+{
+    int to = n->edges[slot].to;
+
+    n->in_prev[slot] = -1;
+    n->in_next[slot] = n->in_head[to];
+    if (n->in_head[to] >= 0) n->in_prev[n->in_head[to]] = slot;
+    n->in_head[to] = slot;
+}
+
+void
+nav_unlink_edge(Nav *n, int slot)
+{
+    int to = n->edges[slot].to;
+
+    if (n->in_prev[slot] >= 0) {
+        n->in_next[n->in_prev[slot]] = n->in_next[slot];
+    } else {
+        n->in_head[to] = n->in_next[slot];
+    }
+    if (n->in_next[slot] >= 0) n->in_prev[n->in_next[slot]] = n->in_prev[slot];
+}
+
+void
+nav_update_node(Nav *n, int node)
+{
+    if (node != n->work_goal) {
+        int best = INT32_MAX, best_slot = -1;
+
+        for (int e = 0; e < n->num_edges[node]; e++) {
+            int slot = node * NAV_MAX_EDGES + e;
+            int g    = n->work_dist[n->edges[slot].to];
+            if (g == INT32_MAX || g + n->edges[slot].cost >= best) continue;
+            best      = g + n->edges[slot].cost;
+            best_slot = slot;
+        }
+
+        n->work_rhs[node] = best;
+        if (best_slot != n->work_next[node]) {
+            n->work_next[node] = best_slot;
+            nav_mark_changed(n, node);
+        }
+    }
+
+    if (n->work_dist[node] != n->work_rhs[node]) {
+        nav_heap_push(n, SDL_min(n->work_dist[node], n->work_rhs[node]), node);
+    }
+}
+
+void
+nav_mark_changed(Nav *n, int node)
+{
+    if (n->changed[node]) return;
+
+    n->changed[node] = 1;
+    n->changed_list[n->num_changed++] = node;
+}
+
+void
+nav_publish(Nav *n)
+{
+    if (n->num_changed == 0 && n->goal == n->work_goal) return;
+
+    for (int i = 0; i < n->num_changed; i++) {
+        int node = n->changed_list[i];
+        int slot = n->work_next[node];
+
+        n->dist[node]    = n->work_dist[node];
+        n->next[node]    = slot >= 0 ? n->edges[slot] : (Nav_Edge) {.to = -1, .action = NAV_NONE, .cost = 0};
+        n->changed[node] = 0;
+    }
+    n->num_changed = 0;
+    n->goal        = n->work_goal;
+    n->publishes++;
+}
+
+bool
+nav_heap_push(Nav *n, int d, int node)
+{
+    if (n->heap_len >= n->heap_cap) {
+        int cap = n->heap_cap > 0 ? n->heap_cap * 2 : 1024;
+        Nav_Heap_Item *heap = realloc(n->heap, sizeof(Nav_Heap_Item) * cap);
+        if (heap == NULL) {
+            if (!n->stalled) printf("Nav heap couldn't grow, keeping the last field\n");
+            n->stalled = true;
+            return false;
+        }
+        n->heap     = heap;
+        n->heap_cap = cap;
+    }
+
+    int i = n->heap_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (n->heap[parent].d <= d) break;
+        n->heap[i] = n->heap[parent];
+        i = parent;
+    }
+    n->heap[i] = (Nav_Heap_Item) {.d = d, .node = node};
+
+    return true;
+}
+
+Nav_Heap_Item
+nav_heap_pop(Nav *n)
+{
+    Nav_Heap_Item top  = n->heap[0];
+    Nav_Heap_Item last = n->heap[--n->heap_len];
+    int i = 0;
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n->heap_len) break;
+        if (child + 1 < n->heap_len && n->heap[child + 1].d < n->heap[child].d) child++;
+        if (n->heap[child].d >= last.d) break;
+        n->heap[i] = n->heap[child];
+        i = child;
+    }
+    if (n->heap_len > 0) n->heap[i] = last;
+
+    return top;
+}
@@ -0,0 +1,178 @@
+#include "caves.h"
+
+//::particles
+Particles*
+init_particles(int capacity, bool collide)
+{
+    Particles *ps;
+
+    ps = malloc(sizeof(Particles));
+    if (ps == NULL) return NULL;
+
+    ps->count    = 0;
+    ps->capacity = capacity;
+    ps->collide  = collide;
+    ps->x        = malloc(sizeof(float) * capacity);
+    ps->y        = malloc(sizeof(float) * capacity);
+    ps->vx       = malloc(sizeof(float) * capacity);
+    ps->vy       = malloc(sizeof(float) * capacity);
+    ps->life     = malloc(sizeof(float) * capacity);
+    ps->frame    = malloc(sizeof(uint8_t) * capacity);
+    ps->verts    = malloc(sizeof(SDL_Vertex) * 4 * capacity);
+    ps->indices  = malloc(sizeof(int) * 6 * capacity);
+
+    if (!ps->x || !ps->y || !ps->vx || !ps->vy || !ps->life || !ps->frame ||
+        !ps->verts || !ps->indices) {
+        free_particles(ps);
+        return NULL;
+    }
+
+    /*quads never change topology, so the index buffer is built once*/
+    for (int i = 0; i < capacity; i++) {
+        int *idx = &ps->indices[i * 6];
+        idx[0] = i * 4;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 2;
+        idx[4] = i * 4 + 3;
+        idx[5] = i * 4;
+    }
+
+    return ps;
+}
+
+void
+emit_particles(Particles *ps, SDL_FPoint pos, int n, float speed, float life_ms)
+{
+    for (int i = 0; i < n && ps->count < ps->capacity; i++) {
+        int k = ps->count++;
+        ps->x[k]     = pos.x;
+        ps->y[k]     = pos.y;
+        ps->vx[k]    = (SDL_randf() - 0.5f) * 2.0f * speed;
+        ps->vy[k]    = -SDL_randf() * speed;
+        ps->life[k]  = life_ms * (0.5f + 0.5f * SDL_randf());
+        ps->frame[k] = (uint8_t) SDL_rand(4);
+    }
+}
+
+void
+update_particles(Particles *ps, Map *m, uint64_t e_t)
+{
+    float dt = (float) e_t;
+    int i, n = ps->count;
+    float * restrict x    = ps->x;
+    float * restrict y    = ps->y;
+    float * restrict vx   = ps->vx;
+    float * restrict vy   = ps->vy;
+    float * restrict life = ps->life;
+
+    /*branch-free integration, one stream per field*/
+    for (i = 0; i < n; i++) {
+        vy[i] += PARTICLE_GRAVITY * dt;
+    }
+    for (i = 0; i < n; i++) {
+        x[i]    += vx[i] * dt;
+        y[i]    += vy[i] * dt;
+        life[i] -= dt;
+    }
+
+    if (ps->collide && m != NULL) {
+        collide_particles(ps, m, dt);
+    }
+
+    /*swap-remove the dead, order doesn't matter for additive dust*/
+    i = 0;
+    while (i < n) {
+        if (life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        n--;
+        x[i]         = x[n];
+        y[i]         = y[n];
+        vx[i]        = vx[n];
+        vy[i]        = vy[n];
+        life[i]      = life[n];
+        ps->frame[i] = ps->frame[n];
+    }
+    ps->count = n;
+}
+
+void
+collide_particles(Particles *ps, Map *m, float dt)
+{
+    /*reads the row masks directly, this loop runs for every live particle*/
+    float inv_tile = 1.0f / TILE_SIZE;
+    float max_x = (float) m->cols * TILE_SIZE, max_y = (float) m->rows * TILE_SIZE;
+
+    for (int i = 0; i < ps->count; i++) {
+        float px = ps->x[i], py = ps->y[i];
+        if (px < 0.0f || py < 0.0f || px >= max_x || py >= max_y) continue;
+
+        int row = (int) (py * inv_tile), col = (int) (px * inv_tile);
+        uint64_t *mask = &m->solid_mask[row * m->mask_words];
+        if (!((mask[col >> 6] >> (col & 63)) & 1)) continue;
+
+        /*undo the vertical step first, if that clears the wall it was a
+          floor or ceiling, otherwise it hit a side*/
+        float prev_y = py - ps->vy[i] * dt;
+        if (!tile_is_solid(m, (int) floorf(prev_y * inv_tile), col)) {
+            ps->y[i]   = prev_y;
+            ps->vy[i] *= -0.3f;
+            ps->vx[i] *= 0.6f;
+        } else {
+            ps->x[i]  -= ps->vx[i] * dt;
+            ps->vx[i] *= -0.4f;
+        }
+    }
+}
+
+void
+draw_particles(Game *g, Particles *ps)
+{
+    float tex_w, tex_h;
+
+    if (ps->count == 0 || g->spritesheet == NULL) return;
+    if (!SDL_GetTextureSize(g->spritesheet, &tex_w, &tex_h)) return;
+
+    /*chips of the wall tile, frame picks which one*/
+    float u0 = 0.0f, v0 = 2.0f * TILE_SIZE / tex_h;
+    float du = PARTICLE_SIZE / tex_w, dv = PARTICLE_SIZE / tex_h;
+
+    for (int i = 0; i < ps->count; i++) {
+        SDL_Vertex *v = &ps->verts[i * 4];
+        float px = ps->x[i] - g->camera.x, py = ps->y[i] - g->camera.y;
+        float u  = u0 + ps->frame[i] * 4.0f / tex_w;
+        float a  = ps->life[i] < 150.0f ? ps->life[i] / 150.0f : 1.0f;
+        SDL_FColor c = (SDL_FColor) {1.0f, 1.0f, 1.0f, a};
+
+        v[0] = (SDL_Vertex) {{px, py}, c, {u, v0}};
+        v[1] = (SDL_Vertex) {{px + PARTICLE_SIZE, py}, c, {u + du, v0}};
+        v[2] = (SDL_Vertex) {{px + PARTICLE_SIZE, py + PARTICLE_SIZE}, c, {u + du, v0 + dv}};
+        v[3] = (SDL_Vertex) {{px, py + PARTICLE_SIZE}, c, {u, v0 + dv}};
+    }
+
+    SDL_RenderGeometry(g->renderer,
+        g->spritesheet,
+        ps->verts,
+        ps->count * 4,
+        ps->indices,
+        ps->count * 6);
+}
+
+void
+free_particles(Particles *ps)
+{
+    if (ps != NULL) {
+        printf("...freeing Particles\n");
+        free(ps->x);
+        free(ps->y);
+        free(ps->vx);
+        free(ps->vy);
+        free(ps->life);
+        free(ps->frame);
+        free(ps->verts);
+        free(ps->indices);
+        free(ps);
+    }
+}
@@ -0,0 +1,345 @@
+#include "caves.h"
+
+//::platforms
+Platforms*
+init_platforms(Map *m, int capacity)
+{
+    Platforms *ps;
+
+    ps = calloc(1, sizeof(Platforms));
+    if (ps == NULL) return NULL;
+
+    ps->capacity   = capacity;
+    ps->grid_rows  = (m->rows * TILE_SIZE + PLATFORM_CELL - 1) / PLATFORM_CELL;
+    ps->grid_cols  = (m->cols * TILE_SIZE + PLATFORM_CELL - 1) / PLATFORM_CELL;
+    ps->list       = malloc(sizeof(Platform) * capacity);
+    ps->stamp      = calloc(capacity, sizeof(uint32_t));
+    ps->start      = calloc(ps->grid_rows * ps->grid_cols + 1, sizeof(int));
+    ps->items      = NULL;
+    ps->items_cap  = 0;
+    ps->grid_dirty = true;
+
+    if (ps->list == NULL || ps->stamp == NULL || ps->start == NULL) {
+        free_platforms(ps);
+        return NULL;
+    }
+
+    return ps;
+}
+
+int
+add_platform(Platforms *ps, Platform_Kind kind, SDL_FRect box, SDL_FPoint to, float period_ms)
+{
+    if (ps == NULL || ps->count >= ps->capacity) return -1;
+
+    ps->list[ps->count] = (Platform) {
+        .kind      = kind,
+        .box       = box,
+        .from      = (SDL_FPoint) {box.x, box.y},
+        .to        = to,
+        .period_ms = period_ms,
+        .t_ms      = 0.0f,
+        .delta     = (SDL_FPoint) {0.0f, 0.0f},
+        .solid     = true,
+        .crumbling = false,
+        .timer_ms  = 0.0f,
+        .span      = platform_cell_span(ps, box),
+    };
+    ps->grid_dirty = true;
+
+    return ps->count++;
+}
+
+void
+gen_test_platforms(Map *m)
+{
+    m->platforms = init_platforms(m, 16);
+    if (m->platforms == NULL) return;
+
+    /*one sliding over the floor and a crumbling ledge past the door*/
+    add_platform(m->platforms, PLAT_MOVING,
+        (SDL_FRect) {9 * TILE_SIZE, 5 * TILE_SIZE + 8, 2 * TILE_SIZE, 8},
+        (SDL_FPoint) {13 * TILE_SIZE, 5 * TILE_SIZE + 8},
+        4000.0f);
+    add_platform(m->platforms, PLAT_CRUMBLING,
+        (SDL_FRect) {16 * TILE_SIZE, 5 * TILE_SIZE, 2 * TILE_SIZE, 8},
+        (SDL_FPoint) {16 * TILE_SIZE, 5 * TILE_SIZE},
+        0.0f);
+}
+
+SDL_Rect
+platform_cell_span(Platforms *ps, SDL_FRect box)
+{
+    int left  = SDL_max((int) floorf(box.x / PLATFORM_CELL), 0);
+    int top   = SDL_max((int) floorf(box.y / PLATFORM_CELL), 0);
+    int right = SDL_min((int) floorf((box.x + box.w) / PLATFORM_CELL), ps->grid_cols - 1);
+    int bot   = SDL_min((int) floorf((box.y + box.h) / PLATFORM_CELL), ps->grid_rows - 1);
+
+    if (right < left || bot < top) return (SDL_Rect) {0, 0, 0, 0};
+
+    return (SDL_Rect) {left, top, right - left + 1, bot - top + 1};
+}
+
+void
+update_platforms(Platforms *ps, uint64_t e_t)
+{
+    if (ps == NULL) return;
+
+    for (int i = 0; i < ps->count; i++) {
+        Platform *pl = &ps->list[i];
+        SDL_FPoint old = (SDL_FPoint) {pl->box.x, pl->box.y};
+
+        if (pl->kind == PLAT_MOVING && pl->period_ms > 0.0f) {
+            pl->t_ms = fmodf(pl->t_ms + e_t, pl->period_ms);
+            float phase = pl->t_ms / pl->period_ms;
+            float k = phase < 0.5f ? phase * 2.0f : 2.0f - phase * 2.0f;
+            pl->box.x = pl->from.x + (pl->to.x - pl->from.x) * k;
+            pl->box.y = pl->from.y + (pl->to.y - pl->from.y) * k;
+        } else if (pl->kind == PLAT_CRUMBLING && (pl->crumbling || !pl->solid)) {
+            pl->timer_ms -= e_t;
+            if (pl->timer_ms <= 0.0f && pl->solid) {
+                pl->solid     = false;
+                pl->crumbling = false;
+                pl->timer_ms  = CRUMBLE_RESPAWN_MS;
+            } else if (pl->timer_ms <= 0.0f) {
+                pl->solid = true;
+            }
+        }
+
+        pl->delta = (SDL_FPoint) {pl->box.x - old.x, pl->box.y - old.y};
+
+        /*most steps stay inside the same cells, those leave the grid alone*/
+        SDL_Rect span = platform_cell_span(ps, pl->box);
+        if (span.x != pl->span.x || span.y != pl->span.y ||
+            span.w != pl->span.w || span.h != pl->span.h) {
+            pl->span       = span;
+            ps->grid_dirty = true;
+        }
+    }
+
+    ps->tick++;
+    if (ps->grid_dirty) rebuild_platform_grid(ps);
+}
+
+bool
+rebuild_platform_grid(Platforms *ps)
+{
+    int cells = ps->grid_rows * ps->grid_cols;
+    int i, r, c, total = 0;
+
+    for (i = 0; i < ps->count; i++) {
+        total += ps->list[i].span.w * ps->list[i].span.h;
+    }
+    if (total > ps->items_cap) {
+        int *items = realloc(ps->items, sizeof(int) * total);
+        if (items == NULL) return false;
+        ps->items     = items;
+        ps->items_cap = total;
+    }
+
+    for (i = 0; i <= cells; i++) {
+        ps->start[i] = 0;
+    }
+    for (i = 0; i < ps->count; i++) {
+        SDL_Rect s = ps->list[i].span;
+        for (r = s.y; r < s.y + s.h; r++) {
+            for (c = s.x; c < s.x + s.w; c++) {
+                ps->start[r * ps->grid_cols + c + 1]++;
+            }
+        }
+    }
+    for (i = 0; i < cells; i++) {
+        ps->start[i + 1] += ps->start[i];
+    }
+
+    /*start[] doubles as the fill cursor, afterwards each entry holds the
+      end of its cell so shifting by one restores the heads*/
+    for (i = 0; i < ps->count; i++) {
+        SDL_Rect s = ps->list[i].span;
+        for (r = s.y; r < s.y + s.h; r++) {
+            for (c = s.x; c < s.x + s.w; c++) {
+                ps->items[ps->start[r * ps->grid_cols + c]++] = i;
+            }
+        }
+    }
+    for (i = cells; i > 0; i--) {
+        ps->start[i] = ps->start[i - 1];
+    }
+    ps->start[0] = 0;
+
+    ps->grid_dirty = false;
+    ps->rebuilds++;
+    return true;
+}
+
+Collision_Info
+collide_platforms(Platforms *ps, SDL_FRect r, int dx, int dy)
+{
+    Collision_Info info = (Collision_Info) {.collided = false, .platform = -1, .tile = -1};
+
+    /*same inclusive pixel edges as the tile test, so standing on a
+      platform's top counts as touching it*/
+    int left = rect_left(r), right = rect_right(r);
+    int top  = rect_top(r),  bot   = rect_bot(r);
+
+    if (++ps->query == 0) {
+        for (int i = 0; i < ps->count; i++) {
+            ps->stamp[i] = 0;
+        }
+        ps->query = 1;
+    }
+    ps->queries++;
+
+    SDL_Rect span = platform_cell_span(ps, r);
+    for (int row = span.y; row < span.y + span.h; row++) {
+        for (int col = span.x; col < span.x + span.w; col++) {
+            int cell = row * ps->grid_cols + col;
+            for (int k = ps->start[cell]; k < ps->start[cell + 1]; k++) {
+                int i = ps->items[k];
+                Platform *pl = &ps->list[i];
+                if (ps->stamp[i] == ps->query || !pl->solid) continue;
+                ps->stamp[i] = ps->query;
+                ps->tests++;
+
+                int p_left = (int) floorf(pl->box.x), p_top = (int) floorf(pl->box.y);
+                if (left > p_left + (int) pl->box.w - 1 || right < p_left ||
+                    top > p_top + (int) pl->box.h - 1 || bot < p_top) {
+                    continue;
+                }
+
+                /*keep whichever surface the motion reaches first*/
+                SDL_FRect b = pl->box;
+                bool better = !info.collided ||
+                    (dy > 0 && b.y < info.rect.y) ||
+                    (dy < 0 && b.y + b.h > info.rect.y + info.rect.h) ||
+                    (dx > 0 && b.x < info.rect.x) ||
+                    (dx < 0 && b.x + b.w > info.rect.x + info.rect.w);
+                if (better) {
+                    info = (Collision_Info) {
+                        .collided = true,
+                        .row      = p_top / TILE_SIZE,
+                        .col      = p_left / TILE_SIZE,
+                        .rect     = b,
+                        .platform = i,
+                        .tile     = -1,
+                    };
+                }
+            }
+        }
+    }
+
+    return info;
+}
+
+void
+stand_on_platform(Platforms *ps, int id)
+{
+    if (ps == NULL || id < 0 || id >= ps->count) return;
+
+    Platform *pl = &ps->list[id];
+    if (pl->kind == PLAT_CRUMBLING && pl->solid && !pl->crumbling) {
+        pl->crumbling = true;
+        pl->timer_ms  = CRUMBLE_MS;
+    }
+}
+
+void
+carry_rider(Player *p, Map *m)
+{
+    Platforms *ps = m != NULL ? m->platforms : NULL;
+    int id = p->physics.platform;
+
+    if (ps == NULL || id < 0 || id >= ps->count || !p->physics.on_ground) return;
+
+    Platform *pl = &ps->list[id];
+    if (!pl->solid) {
+        p->physics.platform  = -1;
+        p->physics.on_ground = false;
+        return;
+    }
+
+    /*everything the platform did since this body last ran, so bodies that
+      skip ticks keep up and substeps after the first move nothing*/
+    p->pos.x += pl->box.x - p->physics.carried_from.x;
+    p->pos.y += pl->box.y - p->physics.carried_from.y;
+    p->physics.carried_from = (SDL_FPoint) {pl->box.x, pl->box.y};
+}
+
+uint32_t
+platforms_signature(Game *g, Platforms *ps)
+{
+    uint32_t sig = 2166136261u;
+
+    if (ps == NULL) return sig;
+
+    for (int i = 0; i < ps->count; i++) {
+        Platform *pl = &ps->list[i];
+        if (pl->box.x + pl->box.w < g->camera.x || pl->box.x > g->camera.x + G_WIDTH ||
+            pl->box.y + pl->box.h < g->camera.y || pl->box.y > g->camera.y + G_HEIGHT) {
+            continue;
+        }
+
+        /*a crumbling platform shakes, so its timer counts as a change too*/
+        uint32_t v[3] = {
+            (uint32_t) round(pl->box.x), (uint32_t) round(pl->box.y),
+            (uint32_t) pl->solid | (pl->crumbling ? (uint32_t) pl->timer_ms / 40 << 1 : 0),
+        };
+        for (int k = 0; k < 3; k++) {
+            sig = (sig ^ v[k]) * 16777619u;
+        }
+    }
+
+    return sig;
+}
+
+void
+draw_platforms(Game *g, Platforms *ps)
+{
+    if (ps == NULL || g->spritesheet == NULL) return;
+
+    for (int i = 0; i < ps->count; i++) {
+        Platform *pl = &ps->list[i];
+        if (!pl->solid) continue;
+
+        /*top strip of the wall tile, repeated along the platform*/
+        float shake = pl->crumbling ? (float) SDL_rand(3) - 1.0f : 0.0f;
+        for (float x = 0; x < pl->box.w; x += TILE_SIZE) {
+            float w = SDL_min(TILE_SIZE, pl->box.w - x);
+            SDL_FRect src  = (SDL_FRect) {0, 2 * TILE_SIZE, w, pl->box.h};
+            SDL_FRect dest = (SDL_FRect) {
+                .x = roundf(pl->box.x + x - g->camera.x + shake),
+                .y = roundf(pl->box.y - g->camera.y),
+                .w = w,
+                .h = pl->box.h,
+            };
+            SDL_RenderTexture(g->renderer, g->spritesheet, &src, &dest);
+        }
+    }
+}
+
+void
+print_platform_stats(Platforms *ps)
+{
+    if (ps == NULL || ps->queries == 0) return;
+
+    printf("platforms: %d bodies, %llu queries, %.2f narrow tests per query, %llu grid rebuilds over %u ticks\n",
+        ps->count,
+        (unsigned long long) ps->queries,
+        (double) ps->tests / ps->queries,
+        (unsigned long long) ps->rebuilds,
+        ps->tick);
+}
+
+void
+free_platforms(Platforms *ps)
+{
+    if (ps != NULL) {
+        printf("...freeing Platforms\n");
+        print_platform_stats(ps);
+        free(ps->list);
+        free(ps->stamp);
+        free(ps->start);
+        free(ps->items);
+        free(ps);
+    }
+}
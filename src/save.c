@@ -0,0 +1,426 @@
+#include "caves.h"
+
+//::save
+Save_State*
+init_save_state(Map *m)
+{
+    Save_State *sv;
+    int chunks = m->chunk_rows * m->chunk_cols;
+
+    sv = calloc(1, sizeof(Save_State));
+    if (sv == NULL) return NULL;
+
+    sv->rows         = m->rows;
+    sv->cols         = m->cols;
+    sv->chunk_rows   = m->chunk_rows;
+    sv->chunk_cols   = m->chunk_cols;
+    sv->baseline     = malloc(sizeof(uint8_t) * m->rows * m->cols);
+    sv->pending      = calloc(chunks, sizeof(uint8_t*));
+    sv->pending_len  = calloc(chunks, sizeof(int));
+    sv->has_pending  = calloc(chunks, sizeof(bool));
+    sv->pending_list = malloc(sizeof(int) * chunks);
+    SDL_SetAtomicInt(&sv->done, 0);
+
+    if (sv->baseline == NULL || sv->pending == NULL || sv->pending_len == NULL ||
+        sv->has_pending == NULL || sv->pending_list == NULL) {
+        free_save_state(sv);
+        return NULL;
+    }
+
+    /*whatever the level looks like now is what saves are relative to*/
+    for (int row = 0; row < m->rows; row++) {
+        for (int col = 0; col < m->cols; col++) {
+            sv->baseline[row * m->cols + col] = (uint8_t) m->tile_id[row][col];
+        }
+    }
+    while (m->num_modified > 0) {
+        map_clear_modified(m, m->modified_chunks[0]);
+    }
+
+    return sv;
+}
+
+bool
+save_game(Save_State *sv, Map *m, Player *p, Interactables *ix, char *filepath)
+{
+    int side = CHUNK_TILES * CHUNK_TILES, n, i;
+
+    if (sv->writer != NULL) {
+        printf("save already in progress\n");
+        return false;
+    }
+
+    uint64_t start = SDL_GetTicksNS();
+
+    /*a save still waiting to be applied has to land before it can be diffed*/
+    for (i = 0; i < sv->pending_total && sv->pending_count > 0; i++) {
+        int chunk = sv->pending_list[i];
+        if (sv->has_pending[chunk]) apply_chunk_delta(sv, m, chunk);
+    }
+
+    n = m->num_modified;
+
+    Save_Job *job = calloc(1, sizeof(Save_Job));
+    if (job == NULL) return false;
+
+    job->path        = filepath;
+    job->rows        = m->rows;
+    job->cols        = m->cols;
+    job->chunk_cols  = m->chunk_cols;
+    job->baseline    = sv->baseline;
+    job->num_chunks  = n;
+    job->chunk_ids   = malloc(sizeof(int) * (n > 0 ? n : 1));
+    job->tiles       = malloc(sizeof(uint8_t) * side * (n > 0 ? n : 1));
+    job->objects     = malloc(sizeof(Save_Object) * (ix->object_cells.count + 1));
+    job->player_pos  = p->pos;
+    job->start_ns    = start;
+    job->done        = &sv->done;
+
+    if (job->chunk_ids == NULL || job->tiles == NULL || job->objects == NULL) {
+        free_save_job(job);
+        return false;
+    }
+
+    /*the snapshot only copies what changed, everything else is the baseline*/
+    for (n = 0; n < m->num_modified; n++) {
+        int chunk = m->modified_chunks[n];
+        int c_row = chunk / m->chunk_cols, c_col = chunk % m->chunk_cols;
+        uint8_t *dst = &job->tiles[n * side];
+        for (int r = 0; r < CHUNK_TILES; r++) {
+            for (int c = 0; c < CHUNK_TILES; c++) {
+                int row = c_row * CHUNK_TILES + r, col = c_col * CHUNK_TILES + c;
+                bool inside = row < m->rows && col < m->cols;
+                dst[r * CHUNK_TILES + c] = inside ? (uint8_t) m->tile_id[row][col] : 0;
+            }
+        }
+        job->chunk_ids[n] = chunk;
+    }
+
+    for (i = 0; i < ix->object_cells.count; i++) {
+        if (ix->objects[i].on) {
+            job->objects[job->num_objects++] = (Save_Object) {.id = i, .on = true};
+        }
+    }
+
+    job->snapshot_ns = SDL_GetTicksNS() - start;
+
+    SDL_SetAtomicInt(&sv->done, 0);
+    sv->job    = job;
+    sv->writer = SDL_CreateThread(save_writer, "save writer", job);
+    if (sv->writer == NULL) {
+        printf("Save thread couldn't start: %s\n", SDL_GetError());
+        sv->job = NULL;
+        free_save_job(job);
+        return false;
+    }
+
+    return true;
+}
+
+int SDLCALL
+save_writer(void *data)
+{
+    Save_Job *job = data;
+    int side = CHUNK_TILES * CHUNK_TILES;
+    uint8_t base[CHUNK_TILES * CHUNK_TILES];
+    uint8_t packed[2 * CHUNK_TILES * CHUNK_TILES];
+    int32_t head[4];
+    char tmp[256];
+
+    /*written beside the save and renamed over it, so a load or a crash
+      mid-write never sees half a file*/
+    SDL_snprintf(tmp, sizeof(tmp), "%s.tmp", job->path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        SDL_SetAtomicInt(job->done, 1);
+        return 1;
+    }
+
+    bool ok = fwrite(SAVE_MAGIC, 1, 8, f) == 8;
+    head[0] = job->rows;
+    head[1] = job->cols;
+    head[2] = job->num_objects;
+    head[3] = job->num_chunks;
+    ok = ok && fwrite(head, sizeof(int32_t), 4, f) == 4;
+    ok = ok && fwrite(&job->player_pos, sizeof(SDL_FPoint), 1, f) == 1;
+
+    for (int i = 0; ok && i < job->num_objects; i++) {
+        int32_t id = job->objects[i].id;
+        uint8_t on = job->objects[i].on;
+        ok = fwrite(&id, sizeof(int32_t), 1, f) == 1 && fwrite(&on, 1, 1, f) == 1;
+    }
+
+    for (int i = 0; ok && i < job->num_chunks; i++) {
+        int chunk = job->chunk_ids[i];
+        int c_row = chunk / job->chunk_cols, c_col = chunk % job->chunk_cols;
+
+        /*the baseline never changes once taken, so it's safe to read here*/
+        for (int r = 0; r < CHUNK_TILES; r++) {
+            for (int c = 0; c < CHUNK_TILES; c++) {
+                int row = c_row * CHUNK_TILES + r, col = c_col * CHUNK_TILES + c;
+                bool inside = row < job->rows && col < job->cols;
+                base[r * CHUNK_TILES + c] = inside ? job->baseline[row * job->cols + col] : 0;
+            }
+        }
+
+        int32_t id = chunk;
+        uint8_t len = (uint8_t) encode_chunk(&job->tiles[i * side], base, packed);
+        ok = fwrite(&id, sizeof(int32_t), 1, f) == 1 &&
+             fwrite(&len, 1, 1, f) == 1 &&
+             fwrite(packed, 1, len, f) == len;
+    }
+
+    job->bytes = (size_t) ftell(f);
+    job->ok    = fclose(f) == 0 && ok && SDL_RenamePath(tmp, job->path);
+    if (!job->ok) SDL_RemovePath(tmp);
+
+    SDL_SetAtomicInt(job->done, 1);
+    return job->ok ? 0 : 1;
+}
+
+int
+encode_chunk(const uint8_t *tiles, const uint8_t *base, uint8_t *out)
+{
+    int side = CHUNK_TILES * CHUNK_TILES, n = 0;
+
+    /*xor against the baseline leaves zeros wherever nothing changed, and
+      run lengths collapse those, an edited chunk is usually a few bytes*/
+    for (int i = 0; i < side;) {
+        uint8_t v = tiles[i] ^ base[i];
+        int run = 1;
+        while (i + run < side && run < 255 && (tiles[i + run] ^ base[i + run]) == v) {
+            run++;
+        }
+        out[n++] = (uint8_t) run;
+        out[n++] = v;
+        i += run;
+    }
+
+    return n;
+}
+
+bool
+decode_chunk(const uint8_t *in, int len, uint8_t *delta)
+{
+    int side = CHUNK_TILES * CHUNK_TILES, n = 0;
+
+    for (int i = 0; i + 1 < len; i += 2) {
+        if (n + in[i] > side) return false;
+        for (int k = 0; k < in[i]; k++) {
+            delta[n++] = in[i + 1];
+        }
+    }
+    for (; n < side; n++) {
+        delta[n] = 0;
+    }
+
+    return true;
+}
+
+void
+poll_save(Save_State *sv)
+{
+    if (sv == NULL || sv->writer == NULL || !SDL_GetAtomicInt(&sv->done)) return;
+
+    finish_save(sv);
+}
+
+void
+finish_save(Save_State *sv)
+{
+    SDL_WaitThread(sv->writer, NULL);
+    Save_Job *job = sv->job;
+
+    if (job->ok) {
+        sv->saves++;
+        printf("saved %d chunks, %d objects, %zu bytes in %.2f ms (snapshot %.1f us)\n",
+            job->num_chunks, job->num_objects, job->bytes,
+            (SDL_GetTicksNS() - job->start_ns) / 1e6, job->snapshot_ns / 1e3);
+    } else {
+        printf("Couldn't write save to %s\n", job->path);
+    }
+
+    free_save_job(job);
+    sv->job    = NULL;
+    sv->writer = NULL;
+}
+
+bool
+load_game(Save_State *sv, Map *m, Player *p, Interactables *ix, char *filepath)
+{
+    char magic[8];
+    int32_t head[4];
+    SDL_FPoint pos;
+    int chunks = m->chunk_rows * m->chunk_cols, i;
+
+    /*a save still being written would be read half done*/
+    if (sv->writer != NULL) finish_save(sv);
+
+    FILE *f = fopen(filepath, "rb");
+    if (f == NULL) {
+        printf("No save at %s\n", filepath);
+        return false;
+    }
+
+    bool ok = fread(magic, 1, 8, f) == 8 && SDL_memcmp(magic, SAVE_MAGIC, 8) == 0 &&
+              fread(head, sizeof(int32_t), 4, f) == 4 &&
+              fread(&pos, sizeof(SDL_FPoint), 1, f) == 1 &&
+              head[0] == m->rows && head[1] == m->cols;
+    if (!ok) {
+        printf("Save %s doesn't match this level\n", filepath);
+        fclose(f);
+        return false;
+    }
+
+    /*drop anything still queued from an earlier load*/
+    for (i = 0; i < sv->pending_total; i++) {
+        int chunk = sv->pending_list[i];
+        free(sv->pending[chunk]);
+        sv->pending[chunk]     = NULL;
+        sv->pending_len[chunk] = 0;
+        sv->has_pending[chunk] = false;
+    }
+    sv->pending_total = 0;
+    sv->pending_count = 0;
+
+    /*only the flags, a door's tile comes back with its chunk's delta*/
+    for (i = 0; i < ix->object_cells.count; i++) {
+        ix->objects[i].on = false;
+    }
+    for (i = 0; ok && i < head[2]; i++) {
+        int32_t id;
+        uint8_t on;
+        ok = fread(&id, sizeof(int32_t), 1, f) == 1 && fread(&on, 1, 1, f) == 1;
+        if (ok && id >= 0 && id < ix->object_cells.count) ix->objects[id].on = on != 0;
+    }
+
+    /*chunks are only queued here, apply_pending_chunks lands them as they
+      come near the player, so a load costs what the save held*/
+    for (i = 0; ok && i < head[3]; i++) {
+        int32_t id;
+        uint8_t len;
+        ok = fread(&id, sizeof(int32_t), 1, f) == 1 && fread(&len, 1, 1, f) == 1 &&
+             id >= 0 && id < chunks;
+        if (!ok) break;
+
+        if (sv->has_pending[id]) {
+            free(sv->pending[id]);
+        } else {
+            sv->pending_list[sv->pending_total++] = id;
+            sv->pending_count++;
+        }
+        sv->pending[id]     = malloc(len > 0 ? len : 1);
+        sv->has_pending[id] = true;
+        sv->pending_len[id] = len;
+        ok = sv->pending[id] != NULL && fread(sv->pending[id], 1, len, f) == len;
+    }
+    fclose(f);
+
+    /*chunks edited since the save but not in it go back to the baseline*/
+    for (i = 0; i < m->num_modified; i++) {
+        int chunk = m->modified_chunks[i];
+        if (!sv->has_pending[chunk]) {
+            sv->pending_list[sv->pending_total++] = chunk;
+            sv->has_pending[chunk] = true;
+            sv->pending_count++;
+        }
+    }
+
+    p->pos                 = pos;
+    p->physics.vel_x       = 0.0f;
+    p->physics.vel_y       = 0.0f;
+    p->physics.on_ground   = false;
+    p->physics.platform    = -1;
+
+    if (!ok) printf("Save %s is truncated, loaded what was there\n", filepath);
+    printf("loaded %s, %d chunks queued\n", filepath, sv->pending_count);
+
+    return ok;
+}
+
+void
+apply_pending_chunks(Save_State *sv, Map *m, SDL_Rect view)
+{
+    if (sv == NULL || sv->pending_count == 0) return;
+
+    int left = SDL_max(view.x - SIM_ACTIVE_CHUNKS, 0);
+    int top  = SDL_max(view.y - SIM_ACTIVE_CHUNKS, 0);
+    int right = SDL_min(view.x + view.w + SIM_ACTIVE_CHUNKS, m->chunk_cols);
+    int bot   = SDL_min(view.y + view.h + SIM_ACTIVE_CHUNKS, m->chunk_rows);
+
+    /*same reach as the simulation, nothing further out can be touched yet*/
+    for (int c_row = top; c_row < bot; c_row++) {
+        for (int c_col = left; c_col < right; c_col++) {
+            int chunk = c_row * m->chunk_cols + c_col;
+            if (sv->has_pending[chunk]) apply_chunk_delta(sv, m, chunk);
+        }
+    }
+}
+
+void
+apply_chunk_delta(Save_State *sv, Map *m, int chunk)
+{
+    uint8_t delta[CHUNK_TILES * CHUNK_TILES];
+    int c_row = chunk / m->chunk_cols, c_col = chunk % m->chunk_cols;
+    bool changed = false;
+
+    if (!decode_chunk(sv->pending[chunk], sv->pending_len[chunk], delta)) {
+        printf("Save chunk %d is corrupt, left as it was\n", chunk);
+        for (int i = 0; i < CHUNK_TILES * CHUNK_TILES; i++) {
+            delta[i] = 0;
+        }
+    }
+
+    for (int r = 0; r < CHUNK_TILES; r++) {
+        for (int c = 0; c < CHUNK_TILES; c++) {
+            int row = c_row * CHUNK_TILES + r, col = c_col * CHUNK_TILES + c;
+            if (row >= m->rows || col >= m->cols) continue;
+
+            int want = sv->baseline[row * m->cols + col] ^ delta[r * CHUNK_TILES + c];
+            changed |= delta[r * CHUNK_TILES + c] != 0;
+            map_set_tile(m, row, col, want);
+        }
+    }
+
+    /*back at the baseline the chunk has nothing left to save*/
+    if (!changed) map_clear_modified(m, chunk);
+
+    free(sv->pending[chunk]);
+    sv->pending[chunk]     = NULL;
+    sv->pending_len[chunk] = 0;
+    sv->has_pending[chunk] = false;
+    sv->pending_count--;
+    sv->chunks_applied++;
+}
+
+void
+free_save_job(Save_Job *job)
+{
+    if (job != NULL) {
+        free(job->chunk_ids);
+        free(job->tiles);
+        free(job->objects);
+        free(job);
+    }
+}
+
+void
+free_save_state(Save_State *sv)
+{
+    if (sv != NULL) {
+        printf("...freeing Save State\n");
+        /*the writer reads the baseline, it has to finish first*/
+        if (sv->writer != NULL) finish_save(sv);
+        if (sv->pending != NULL) {
+            for (int i = 0; i < sv->chunk_rows * sv->chunk_cols; i++) {
+                free(sv->pending[i]);
+            }
+        }
+        free(sv->pending);
+        free(sv->pending_len);
+        free(sv->has_pending);
+        free(sv->pending_list);
+        free(sv->baseline);
+        free(sv);
+    }
+}
@@ -0,0 +1,85 @@
+#include "caves.h"
+
+//::stress
+Stress*
+init_stress(Actor_Pool *ap, Map *m, int max_actors)
+{
+    Stress *s;
+
+    s = calloc(1, sizeof(Stress));
+    if (s == NULL) return NULL;
+
+    s->max_actors = max_actors;
+    printf("%-8s %10s %10s %10s %10s   %s\n",
+        "actors", "frame ms", "max ms", "sim ms", "draw ms", "full/reduced/sleep");
+    stress_stage(s, ap, m, 1);
+
+    return s;
+}
+
+void
+stress_stage(Stress *s, Actor_Pool *ap, Map *m, int n)
+{
+    clear_actor_pool(ap);
+
+    /*past one actor per standable tile they start sharing spots*/
+    int placed = populate_actors(ap, m, n);
+    for (int i = placed; i < n && placed > 0; i++) {
+        spawn_actor(ap, ap->actors[i % placed].body->pos);
+    }
+
+    for (int i = 0; i < ap->count; i++) {
+        ap->actors[i].bot = (Bot) {.on = true, .seed = (uint32_t) i * 2654435761u + 1u, .ms_left = 0};
+    }
+
+    s->stage_actors = n;
+    s->frames       = 0;
+    s->frame_ns     = 0;
+    s->frame_ns_max = 0;
+    s->sim_ns       = 0;
+    s->draw_ns      = 0;
+}
+
+bool
+stress_frame(Stress *s, Actor_Pool *ap, Map *m, uint64_t sim_ticks, uint64_t draw_ticks, uint64_t frame_ticks)
+{
+    uint64_t freq     = SDL_GetPerformanceFrequency();
+    uint64_t frame_ns = frame_ticks * 1000000000u / freq;
+
+    s->sim_ns   += sim_ticks * 1000000000u / freq;
+    s->draw_ns  += draw_ticks * 1000000000u / freq;
+    s->frame_ns += frame_ns;
+    if (frame_ns > s->frame_ns_max) s->frame_ns_max = frame_ns;
+
+    if (++s->frames < STRESS_FRAMES) return true;
+
+    print_stress_stage(s, ap);
+    if (s->stage_actors >= s->max_actors) return false;
+
+    /*doubling keeps the ramp short while still showing where it bends*/
+    stress_stage(s, ap, m, SDL_min(s->stage_actors * 2, s->max_actors));
+    return true;
+}
+
+void
+print_stress_stage(Stress *s, Actor_Pool *ap)
+{
+    if (s->frames == 0) return;
+
+    printf("%-8d %10.3f %10.3f %10.3f %10.3f   %d/%d/%d\n",
+        s->stage_actors,
+        s->frame_ns / 1e6 / s->frames,
+        s->frame_ns_max / 1e6,
+        s->sim_ns / 1e6 / s->frames,
+        s->draw_ns / 1e6 / s->frames,
+        ap->tier_count[SIM_FULL], ap->tier_count[SIM_REDUCED], ap->tier_count[SIM_SLEEP]);
+}
+
+void
+free_stress(Stress *s)
+{
+    if (s != NULL) {
+        printf("...freeing Stress\n");
+        free(s);
+    }
+}
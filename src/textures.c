@@ -0,0 +1,168 @@
+#include "caves.h"
+
+//::textures
+Texture_Manager*
+init_texture_manager(SDL_Renderer *r, size_t budget)
+{
+    Texture_Manager *tm;
+
+    tm = calloc(1, sizeof(Texture_Manager));
+    if (tm == NULL) return NULL;
+
+    tm->renderer = r;
+    tm->budget   = budget;
+
+    return tm;
+}
+
+int
+register_texture(Texture_Manager *tm, const char *filepath)
+{
+    if (tm == NULL || tm->count >= MAX_TEXTURES) return -1;
+
+    /*decoded once and kept in system memory, uploads come from here*/
+    SDL_Surface *s = IMG_Load(filepath);
+    if (s == NULL) return -1;
+
+    char *path = SDL_strdup(filepath);
+    if (path == NULL) {
+        SDL_DestroySurface(s);
+        return -1;
+    }
+
+    Texture_Entry *e = &tm->entries[tm->count];
+    *e = (Texture_Entry) {
+        .path      = path,
+        .surface   = s,
+        .texture   = NULL,
+        .bytes     = (size_t) s->w * s->h * 4,
+        .last_used = 0,
+    };
+
+    return tm->count++;
+}
+
+int
+find_texture(Texture_Manager *tm, const char *filepath)
+{
+    if (tm == NULL) return -1;
+
+    for (int i = 0; i < tm->count; i++) {
+        if (SDL_strcmp(tm->entries[i].path, filepath) == 0) return i;
+    }
+
+    return -1;
+}
+
+void
+begin_texture_frame(Texture_Manager *tm)
+{
+    if (tm != NULL) tm->frame++;
+}
+
+SDL_Texture*
+get_texture(Texture_Manager *tm, int handle)
+{
+    if (tm == NULL || handle < 0 || handle >= tm->count) return NULL;
+
+    Texture_Entry *e = &tm->entries[handle];
+    e->last_used = tm->frame;
+
+    if (e->texture != NULL) {
+        tm->hits++;
+        return e->texture;
+    }
+
+    tm->misses++;
+    if (tm->renderer == NULL) return NULL;
+
+    while (tm->resident_bytes + e->bytes > tm->budget && evict_texture(tm)) {}
+
+    e->texture = SDL_CreateTextureFromSurface(tm->renderer, e->surface);
+    if (e->texture == NULL) return NULL;
+
+    SDL_SetTextureScaleMode(e->texture, SDL_SCALEMODE_NEAREST);
+    tm->resident_bytes += e->bytes;
+    tm->upload_bytes   += e->bytes;
+    tm->uploads++;
+
+    return e->texture;
+}
+
+bool
+evict_texture(Texture_Manager *tm)
+{
+    int lru = -1;
+
+    /*anything touched this frame may still be referenced by queued draws*/
+    for (int i = 0; i < tm->count; i++) {
+        Texture_Entry *e = &tm->entries[i];
+        if (e->texture == NULL || e->last_used == tm->frame) continue;
+        if (lru < 0 || e->last_used < tm->entries[lru].last_used) lru = i;
+    }
+    if (lru < 0) return false;
+
+    SDL_DestroyTexture(tm->entries[lru].texture);
+    tm->entries[lru].texture = NULL;
+    tm->resident_bytes      -= tm->entries[lru].bytes;
+    tm->evictions++;
+
+    return true;
+}
+
+bool
+reload_texture(Texture_Manager *tm, int handle)
+{
+    if (tm == NULL || handle < 0 || handle >= tm->count) return false;
+
+    Texture_Entry *e = &tm->entries[handle];
+
+    /*a half-written or broken file keeps the old image around*/
+    SDL_Surface *s = IMG_Load(e->path);
+    if (s == NULL) {
+        printf("Couldn't reload %s: %s\n", e->path, SDL_GetError());
+        return false;
+    }
+
+    /*only this entry goes, the next get_texture uploads the new pixels*/
+    if (e->texture != NULL) {
+        SDL_DestroyTexture(e->texture);
+        e->texture         = NULL;
+        tm->resident_bytes -= e->bytes;
+    }
+    SDL_DestroySurface(e->surface);
+    e->surface = s;
+    e->bytes   = (size_t) s->w * s->h * 4;
+
+    return true;
+}
+
+void
+print_texture_stats(Texture_Manager *tm)
+{
+    if (tm == NULL) return;
+
+    printf("textures: %llu hits, %llu misses, %llu uploads (%.1f KiB), %llu evictions, %.1f/%.1f KiB resident\n",
+        (unsigned long long) tm->hits,
+        (unsigned long long) tm->misses,
+        (unsigned long long) tm->uploads,
+        tm->upload_bytes / 1024.0,
+        (unsigned long long) tm->evictions,
+        tm->resident_bytes / 1024.0,
+        tm->budget / 1024.0);
+}
+
+void
+free_texture_manager(Texture_Manager *tm)
+{
+    if (tm != NULL) {
+        printf("...freeing Texture Manager\n");
+        print_texture_stats(tm);
+        for (int i = 0; i < tm->count; i++) {
+            if (tm->entries[i].texture != NULL) SDL_DestroyTexture(tm->entries[i].texture);
+            SDL_DestroySurface(tm->entries[i].surface);
+            SDL_free(tm->entries[i].path);
+        }
+        free(tm);
+    }
+}
@@ -0,0 +1,252 @@
+#include "caves.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//::watch
+Watcher*
+init_watcher(void)
+{
+    Watcher *w;
+
+    w = calloc(1, sizeof(Watcher));
+    if (w == NULL) return NULL;
+
+    w->fd   = -1;
+    w->lock = SDL_CreateMutex();
+    if (w->lock == NULL) {
+        free(w);
+        return NULL;
+    }
+    SDL_SetAtomicInt(&w->quit, 0);
+
+    return w;
+}
+
+int
+add_watch(Watcher *w, const char *path, Watch_Kind kind, int handle)
+{
+    if (w == NULL || w->count >= MAX_WATCHES || w->thread != NULL) return -1;
+
+    SDL_PathInfo info;
+    w->watches[w->count] = (Watch) {
+        .path   = path,
+        .kind   = kind,
+        .handle = handle,
+        .wd     = -1,
+        .mtime  = SDL_GetPathInfo(path, &info) ? info.modify_time : 0,
+        .queued = false,
+    };
+
+    return w->count++;
+}
+
+bool
+start_watcher(Watcher *w)
+{
+    if (w == NULL || w->count == 0) return false;
+
+#ifdef __linux__
+    /*watching the directory rather than the file survives editors that
+      save by writing a temp file and renaming it over the original*/
+    w->fd = inotify_init1(IN_NONBLOCK);
+    for (int i = 0; i < w->count && w->fd >= 0; i++) {
+        char dir[256];
+        const char *slash = SDL_strrchr(w->watches[i].path, '/');
+        int len = slash != NULL ? (int) (slash - w->watches[i].path) : 0;
+
+        SDL_snprintf(dir, sizeof(dir), "%.*s", len, len > 0 ? w->watches[i].path : ".");
+        w->watches[i].wd = inotify_add_watch(w->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (w->watches[i].wd < 0) {
+            printf("inotify couldn't watch %s, polling instead\n", dir);
+            close(w->fd);
+            w->fd = -1;
+        }
+    }
+#endif
+
+    w->thread = SDL_CreateThread(watcher_thread, "watcher", w);
+    if (w->thread == NULL) {
+        printf("Watcher thread couldn't start: %s\n", SDL_GetError());
+        return false;
+    }
+
+    printf("watching %d files for changes (%s)\n", w->count, w->fd >= 0 ? "inotify" : "polling");
+    return true;
+}
+
+int
+watcher_thread(void *data)
+{
+    Watcher *w = data;
+
+    if (w->fd >= 0) {
+        watch_inotify(w);
+    } else {
+        watch_poll(w);
+    }
+
+    return 0;
+}
+
+void
+watch_inotify(Watcher *w)
+{
+#ifdef __linux__
+    /*aligned for struct inotify_event*/
+    union {
+        struct inotify_event ev;
+        char                 bytes[4096];
+    } buf;
+    struct pollfd pfd = {.fd = w->fd, .events = POLLIN};
+
+    while (!SDL_GetAtomicInt(&w->quit)) {
+        /*the timeout only bounds how long quitting takes*/
+        if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) continue;
+
+        ssize_t n = read(w->fd, buf.bytes, sizeof(buf.bytes));
+        for (ssize_t off = 0; off < n; ) {
+            struct inotify_event *ev = (struct inotify_event *) (buf.bytes + off);
+            off += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0) continue;
+
+            for (int i = 0; i < w->count; i++) {
+                const char *slash = SDL_strrchr(w->watches[i].path, '/');
+                const char *name  = slash != NULL ? slash + 1 : w->watches[i].path;
+                if (w->watches[i].wd == ev->wd && SDL_strcmp(name, ev->name) == 0) {
+                    queue_change(w, i);
+                }
+            }
+        }
+    }
+#else
+    (void) w;
+#endif
+}
+
+void
+watch_poll(Watcher *w)
+{
+    while (!SDL_GetAtomicInt(&w->quit)) {
+        SDL_Delay(WATCH_POLL_MS);
+
+        for (int i = 0; i < w->count; i++) {
+            SDL_PathInfo info;
+            if (!SDL_GetPathInfo(w->watches[i].path, &info)) continue;
+            if (info.modify_time == w->watches[i].mtime) continue;
+
+            w->watches[i].mtime = info.modify_time;
+            queue_change(w, i);
+        }
+    }
+}
+
+void
+queue_change(Watcher *w, int watch)
+{
+    bool wake = false;
+
+    SDL_LockMutex(w->lock);
+    if (!w->watches[watch].queued) {
+        w->watches[watch].queued     = true;
+        w->watches[watch].changed_ns = SDL_GetTicksNS();
+        w->queue[w->queued++]        = watch;
+        wake = true;
+    }
+    SDL_UnlockMutex(w->lock);
+
+    /*an idle main loop sleeps in the event queue, so knock on it*/
+    if (wake) {
+        SDL_Event e = (SDL_Event) {.type = SDL_EVENT_USER};
+        SDL_PushEvent(&e);
+    }
+}
+
+void
+apply_reloads(Game *g, Watcher *w, Map *m, Interactables *ix)
+{
+    int      pending[MAX_WATCHES];
+    uint64_t changed[MAX_WATCHES];
+    int      n;
+
+    if (w == NULL) return;
+
+    SDL_LockMutex(w->lock);
+    n = w->queued;
+    for (int i = 0; i < n; i++) {
+        pending[i] = w->queue[i];
+        changed[i] = w->watches[pending[i]].changed_ns;
+        w->watches[pending[i]].queued = false;
+    }
+    w->queued = 0;
+    SDL_UnlockMutex(w->lock);
+
+    for (int i = 0; i < n; i++) {
+        Watch *wt = &w->watches[pending[i]];
+        uint64_t start = SDL_GetTicksNS();
+        bool ok;
+
+        switch (wt->kind) {
+            case WATCH_TEXTURE:
+                /*chunks baked from this atlas re-bake, sprites pick the new
+                  texture up when the frame fetches it*/
+                ok = reload_texture(g->textures, wt->handle);
+                if (ok) map_mark_atlas_dirty(m, wt->handle);
+                break;
+            case WATCH_LEVEL: {
+                int tiles = map_reload(m, wt->path);
+                ok = tiles >= 0;
+                /*door tiles belong to the doors, not the file*/
+                if (ok) sync_door_tiles(ix, m);
+                if (ok) bind_level_atlases(g->textures, m, g->sheet);
+                if (ok) printf("level %s: %d tiles changed\n", wt->path, tiles);
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+        if (!ok) continue;
+
+        uint64_t end = SDL_GetTicksNS();
+        g->frame_valid = false;
+        w->reloads++;
+        w->apply_ns_total   += end - start;
+        w->latency_ns_total += end - changed[i];
+        if (end - changed[i] > w->latency_ns_max) w->latency_ns_max = end - changed[i];
+
+        printf("reloaded %s in %.3f ms, %.3f ms after the change was seen\n",
+            wt->path, (end - start) / 1e6, (end - changed[i]) / 1e6);
+    }
+}
+
+void
+print_watch_stats(Watcher *w)
+{
+    if (w == NULL || w->reloads == 0) return;
+
+    printf("watch: %llu reloads, %.3f ms avg apply, %.3f ms avg / %.3f ms max latency\n",
+        (unsigned long long) w->reloads,
+        w->apply_ns_total / 1e6 / w->reloads,
+        w->latency_ns_total / 1e6 / w->reloads,
+        w->latency_ns_max / 1e6);
+}
+
+void
+free_watcher(Watcher *w)
+{
+    if (w != NULL) {
+        printf("...freeing Watcher\n");
+        print_watch_stats(w);
+        SDL_SetAtomicInt(&w->quit, 1);
+        SDL_WaitThread(w->thread, NULL);
+#ifdef __linux__
+        if (w->fd >= 0) close(w->fd);
+#endif
+        SDL_DestroyMutex(w->lock);
+        free(w);
+    }
+}